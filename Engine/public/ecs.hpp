@@ -1,15 +1,28 @@
 #pragma once
 
+#include "../src/ECS/BitVector/BitVector.h"
 #include "../src/ECS/ComponentArray/ComponentArray.h"
 #include "../src/ECS/ComponentArray/IComponentArray.h"
+#include "../src/ECS/ComponentArray/PoolStorage.h"
+#include "../src/ECS/ComponentIndex/ComponentIndex.h"
+#include "../src/ECS/ComponentIndex/IComponentIndex.h"
 #include "../src/ECS/ComponentManager/ComponentManager.h"
 #include "../src/ECS/Entity/Entity.h"
 #include "../src/ECS/Entity/Signature.h"
 #include "../src/ECS/EntityManager/EntityManager.h"
 #include "../src/ECS/EntityWrapper/EntityWrapper.h"
+#include "../src/ECS/History/FrameHistory.h"
+#include "../src/ECS/ResourceManager/ResourceManager.h"
 #include "../src/ECS/Scene/Scene.h"
+#include "../src/ECS/Serialization/EntityBatch.h"
+#include "../src/ECS/Serialization/MappedFile.h"
+#include "../src/ECS/Serialization/SaveTask.h"
+#include "../src/ECS/Serialization/SceneFile.h"
+#include "../src/ECS/Serialization/Serialization.h"
+#include "../src/ECS/Shared/Shared.h"
 #include "../src/ECS/System/System.h"
 #include "../src/ECS/SystemManager/SystemManager.h"
+#include "../src/ECS/SystemManager/WorkerPool.h"
 #include "../src/ECS/View/IView.h"
 #include "../src/ECS/View/Iterator/ViewIterator.h"
 #include "../src/ECS/View/View.h"
@@ -1,5 +1,17 @@
 #pragma once
 
+#include "../src/Math/AABBBatch.h"
+#include "../src/Math/Matrix3x2.h"
 #include "../src/Math/Vector2.h"
+#include "../src/Physics/AABBTree.h"
+#include "../src/Physics/Broadphase.h"
 #include "../src/Physics/Components.h"
+#include "../src/Physics/ContactCache.h"
+#include "../src/Physics/Query.h"
+#include "../src/Physics/SleepingBodies.h"
 #include "../src/Physics/System.h"
+#include "../src/Physics/SpatialHash.h"
+#include "../src/Physics/SweepAndPrune.h"
+#include "../src/Physics/TransformSystem.h"
+#include "../src/Physics/TreeBroadphase.h"
+#include "../src/Physics/WorldPartition.h"
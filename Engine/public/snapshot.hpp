@@ -0,0 +1,7 @@
+#pragma once
+
+// Not part of ecs.hpp: the snapshot codec uses Tracy's LZ4, so a target including this header
+// must have Tracy's public directory on its include path and link TracyClient.cpp.
+#include "../src/ECS/Snapshot/SnapshotFormat.h"
+#include "../src/ECS/Snapshot/SnapshotReader.h"
+#include "../src/ECS/Snapshot/SnapshotWriter.h"
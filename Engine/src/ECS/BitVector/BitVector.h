@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "../Serialization/Serialization.h"
+
+namespace Engine::ecs::details
+{
+
+// Growable array of bits kept in lockstep with a dense array
+class BitVector final
+{
+public:
+	void PushBack(bool value)
+	{
+		if (m_size % WordBits == 0)
+		{
+			m_words.push_back(0);
+		}
+
+		++m_size;
+		Set(m_size - 1, value);
+	}
+
+	void PopBack()
+	{
+		assert(m_size > 0 && "BitVector is empty");
+
+		Set(m_size - 1, false);
+		--m_size;
+
+		if (m_size % WordBits == 0)
+		{
+			m_words.pop_back();
+		}
+	}
+
+	void Set(std::size_t index, bool value)
+	{
+		assert(index < m_size && "BitVector index out of range");
+
+		const std::uint64_t mask = std::uint64_t{ 1 } << (index % WordBits);
+		if (value)
+		{
+			m_words[index / WordBits] |= mask;
+		}
+		else
+		{
+			m_words[index / WordBits] &= ~mask;
+		}
+	}
+
+	bool Test(std::size_t index) const
+	{
+		assert(index < m_size && "BitVector index out of range");
+		return (m_words[index / WordBits] >> (index % WordBits)) & 1;
+	}
+
+	void SwapRemove(std::size_t index)
+	{
+		Set(index, Test(m_size - 1));
+		PopBack();
+	}
+
+	// Index of the first clear bit at or after `from`, Size() if there is none
+	std::size_t NextUnset(std::size_t from) const
+	{
+		while (from < m_size)
+		{
+			const std::size_t word = from / WordBits;
+			const std::uint64_t unset = ~m_words[word] >> (from % WordBits);
+
+			if (unset != 0)
+			{
+				return std::min(from + std::countr_zero(unset), m_size);
+			}
+
+			from = (word + 1) * WordBits;
+		}
+
+		return m_size;
+	}
+
+	bool Any() const
+	{
+		return std::ranges::any_of(m_words, [](std::uint64_t word) { return word != 0; });
+	}
+
+	std::size_t Size() const
+	{
+		return m_size;
+	}
+
+	void Clear()
+	{
+		m_words.clear();
+		m_size = 0;
+	}
+
+	void Serialize(std::ostream& stream) const
+	{
+		WriteValue(stream, static_cast<std::uint64_t>(m_size));
+		WriteArray(stream, m_words);
+	}
+
+	bool Deserialize(std::istream& stream)
+	{
+		std::uint64_t size = 0;
+		if (!ReadValue(stream, size) || !ReadArray(stream, m_words))
+		{
+			return false;
+		}
+
+		m_size = static_cast<std::size_t>(size);
+		return m_words.size() == (m_size + WordBits - 1) / WordBits;
+	}
+
+private:
+	static constexpr std::size_t WordBits = 64;
+
+	std::vector<std::uint64_t> m_words;
+	std::size_t m_size = 0;
+};
+
+} // namespace Engine::ecs::details
@@ -1,9 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <utility>
 #include <vector>
 
+#include "../BitVector/BitVector.h"
+#include "../ComponentIndex/ComponentIndex.h"
+#include "../Serialization/MappedFile.h"
+#include "../Serialization/Serialization.h"
+#include "../Shared/Shared.h"
 #include "IComponentArray.h"
+#include "PoolStorage.h"
 
 namespace Engine::ecs
 {
@@ -22,18 +33,85 @@ public:
 
 	bool HasComponent(Entity entity) const;
 
-	std::vector<_TComponent>& GetComponents();
+	std::span<_TComponent> GetComponents();
+
+	std::span<Entity const> GetEntities() const override;
+
+	// Reorders the dense arrays so components are ascending by compare, entity handles stay valid
+	template <typename _TCompare>
+	void Sort(_TCompare compare);
+
+	// Swaps the entity's dense slot with whatever occupies position
+	void MoveTo(Entity entity, size_t position);
+
+	template <IndexKind _Kind, typename _TKey>
+	void CreateIndex(_TKey _TComponent::* member);
+
+	// Calls func with the HashIndex or SortedIndex built over member
+	template <typename _TKey, typename _TFunc>
+	void VisitIndex(_TKey _TComponent::* member, _TFunc&& func) const;
+
+	// Must be called after a mutation through GetComponent for indices to see the new value
+	void MarkChanged(Entity entity);
+
+	// Unlike indices the journal isn't owned, copied or told about loaded components.
+	// Pass nullptr to detach it.
+	void SetJournal(IComponentListener<_TComponent>* journal);
+
+	using SharedValue = typename details::SharedTraits<_TComponent>::ValueType;
+
+	_TComponent Intern(SharedValue const& value)
+		requires details::IsShared<_TComponent>;
+
+	SharedValue const& GetSharedValue(Entity entity) const
+		requires details::IsShared<_TComponent>;
+
+	details::SharedTableFor<_TComponent> const& GetSharedTable() const
+		requires details::IsShared<_TComponent>;
 
 	void OnEntityDestroyed(Entity entity) override final;
 
+	std::shared_ptr<IComponentArray> Clone() const override final;
+
+	std::shared_ptr<IComponentArray> ClonePool() const override final;
+
+	void AssignPool(IComponentArray const& source) override final;
+
+	std::shared_ptr<IComponentArray> CreateEmpty() const override final;
+
+	void CopyEntitiesTo(IComponentArray& target, std::span<Entity const> entities, std::span<Entity const> targetEntities) const override final;
+
+	bool IsSerializable() const override final;
+
+	std::uint64_t GetTypeKey() const override final;
+
+	// Entities, enable bits, shared values and component data are each written as one block
+	void Serialize(std::ostream& stream, details::BitVector const& disabled) const override final;
+
+	// With a mapping, trivially copyable data is viewed in place instead of copied
+	bool Deserialize(std::istream& stream, std::size_t indexCount, std::shared_ptr<details::MappedFile> const& mapping, details::BitVector& disabled) override final;
+
 private:
-	static constexpr size_t InvalidIndex = std::numeric_limits<size_t>::max();
+	void Swap(size_t lhs, size_t rhs);
+
+	template <typename _T>
+	static bool ReadPool(std::istream& stream, std::shared_ptr<details::MappedFile> const& mapping, details::PoolStorage<_T>& pool);
+
+	using DenseIndex = details::EntityIdType;
+
+	static constexpr DenseIndex InvalidIndex = std::numeric_limits<DenseIndex>::max();
+
+	details::PoolStorage<_TComponent> m_components;
+
+	std::vector<DenseIndex> m_sparse;
+
+	details::PoolStorage<Entity> m_denseToEntity;
 
-	std::vector<_TComponent> m_components;
+	std::vector<std::unique_ptr<IComponentIndex<_TComponent>>> m_indices;
 
-	std::vector<size_t> m_sparse;
+	IComponentListener<_TComponent>* m_journal = nullptr;
 
-	std::vector<Entity> m_denseToEntity;
+	[[no_unique_address]] details::SharedTableFor<_TComponent> m_sharedValues;
 };
 
 } // namespace Engine::ecs
@@ -1,6 +1,14 @@
 #pragma once
 
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <span>
+
+#include "../BitVector/BitVector.h"
 #include "../Entity/Entity.h"
+#include "../Serialization/MappedFile.h"
 
 namespace Engine::ecs
 {
@@ -10,6 +18,28 @@ class IComponentArray
 public:
 	virtual ~IComponentArray() = default;
 	virtual void OnEntityDestroyed(Entity entity) = 0;
+	virtual std::shared_ptr<IComponentArray> Clone() const = 0;
+	// Copies the components without their indices, enough to serialize the copy
+	virtual std::shared_ptr<IComponentArray> ClonePool() const = 0;
+	// Same as ClonePool into an existing pool of the same type, reusing its memory
+	virtual void AssignPool(IComponentArray const& source) = 0;
+	// Empty pool of the same component type
+	virtual std::shared_ptr<IComponentArray> CreateEmpty() const = 0;
+	// Adds the component of entities[i], if any, to target as targetEntities[i].
+	// target must hold the same component type.
+	virtual void CopyEntitiesTo(IComponentArray& target, std::span<Entity const> entities, std::span<Entity const> targetEntities) const = 0;
+
+	virtual std::span<Entity const> GetEntities() const = 0;
+
+	// Pools without a ComponentSerializer that are not trivially copyable can't be saved
+	virtual bool IsSerializable() const = 0;
+	virtual std::uint64_t GetTypeKey() const = 0;
+	// Enable bits live with the entities, disabled holds one for each entity of GetEntities
+	virtual void Serialize(std::ostream& stream, details::BitVector const& disabled) const = 0;
+	// Expects an empty pool, mapping is the file stream walks when loading without copies.
+	// Fails on entity indices past indexCount and on entities stored twice. The enable bits are
+	// returned in disabled for the caller to hand to the entities.
+	virtual bool Deserialize(std::istream& stream, std::size_t indexCount, std::shared_ptr<details::MappedFile> const& mapping, details::BitVector& disabled) = 0;
 };
 
 } // namespace Engine::ecs
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace Engine::ecs::details
+{
+
+// Dense array of a pool. Either owns its elements or views memory of a mapped scene file,
+// in which case element writes go to the mapping's private pages and the first change in
+// size copies the elements into owned memory.
+template <typename _T>
+class PoolStorage final
+{
+public:
+	PoolStorage() = default;
+
+	PoolStorage(PoolStorage const& other)
+		: m_owned(other.begin(), other.end())
+	{
+	}
+
+	PoolStorage& operator=(PoolStorage const& other)
+	{
+		if (this != &other)
+		{
+			// Reuses the owned capacity, repeated copies into the same pool don't allocate
+			m_mapped = {};
+			m_mapping.reset();
+			m_owned.assign(other.begin(), other.end());
+		}
+
+		return *this;
+	}
+
+	PoolStorage(PoolStorage&&) noexcept = default;
+	PoolStorage& operator=(PoolStorage&&) noexcept = default;
+
+	PoolStorage& operator=(std::vector<_T>&& values)
+	{
+		m_owned = std::move(values);
+		m_mapped = {};
+		m_mapping.reset();
+
+		return *this;
+	}
+
+	// mapping keeps the memory behind data alive for as long as the view exists
+	void Map(std::shared_ptr<void const> mapping, _T* data, std::size_t count)
+	{
+		m_owned.clear();
+		m_mapped = std::span<_T>(data, count);
+		m_mapping = std::move(mapping);
+	}
+
+	bool IsMapped() const
+	{
+		return m_mapping != nullptr;
+	}
+
+	std::size_t size() const { return IsMapped() ? m_mapped.size() : m_owned.size(); }
+	bool empty() const { return size() == 0; }
+
+	_T* data() { return IsMapped() ? m_mapped.data() : m_owned.data(); }
+	_T const* data() const { return IsMapped() ? m_mapped.data() : m_owned.data(); }
+
+	_T* begin() { return data(); }
+	_T* end() { return data() + size(); }
+	_T const* begin() const { return data(); }
+	_T const* end() const { return data() + size(); }
+
+	_T& operator[](std::size_t index)
+	{
+		assert(index < size() && "Pool index out of range");
+		return data()[index];
+	}
+
+	_T const& operator[](std::size_t index) const
+	{
+		assert(index < size() && "Pool index out of range");
+		return data()[index];
+	}
+
+	_T& back() { return (*this)[size() - 1]; }
+
+	void push_back(_T const& value)
+	{
+		Detach();
+		m_owned.push_back(value);
+	}
+
+	void pop_back()
+	{
+		if (IsMapped())
+		{
+			m_mapped = m_mapped.first(m_mapped.size() - 1);
+		}
+		else
+		{
+			m_owned.pop_back();
+		}
+	}
+
+	void reserve(std::size_t capacity)
+	{
+		Detach();
+		m_owned.reserve(capacity);
+	}
+
+private:
+	void Detach()
+	{
+		if (IsMapped())
+		{
+			m_owned.assign(m_mapped.begin(), m_mapped.end());
+			m_mapped = {};
+			m_mapping.reset();
+		}
+	}
+
+	std::vector<_T> m_owned;
+	std::span<_T> m_mapped;
+	std::shared_ptr<void const> m_mapping;
+};
+
+} // namespace Engine::ecs::details
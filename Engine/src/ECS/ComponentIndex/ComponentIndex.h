@@ -0,0 +1,236 @@
+#pragma once
+
+#include <cassert>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "IComponentIndex.h"
+
+namespace Engine::ecs
+{
+
+enum class IndexKind
+{
+	// O(1) exact lookups, key needs std::hash
+	Hash,
+	// O(log n) exact and range lookups, key needs operator<
+	Sorted,
+};
+
+template <typename _TComponent, typename _TKey>
+class HashIndex final : public IComponentIndex<_TComponent>
+{
+public:
+	using Member = _TKey _TComponent::*;
+
+	explicit HashIndex(Member member)
+		: m_member(member)
+	{
+	}
+
+	Member GetMember() const
+	{
+		return m_member;
+	}
+
+	Entity FindFirst(_TKey const& key) const
+	{
+		auto it = m_buckets.find(key);
+		return it != m_buckets.end() ? it->second.front() : InvalidEntity;
+	}
+
+	template <typename _TFunc>
+	void ForEach(_TKey const& key, _TFunc&& func) const
+	{
+		if (auto it = m_buckets.find(key); it != m_buckets.end())
+		{
+			for (Entity entity : it->second)
+			{
+				func(entity);
+			}
+		}
+	}
+
+	void OnComponentAdded(Entity entity, _TComponent const& component) override
+	{
+		Insert(entity, component.*m_member);
+	}
+
+	void OnComponentRemoved(Entity entity) override
+	{
+		Erase(entity);
+	}
+
+	void OnComponentChanged(Entity entity, _TComponent const& component) override
+	{
+		if (m_slots[entity.Index()].Key == component.*m_member)
+		{
+			return;
+		}
+
+		Erase(entity);
+		Insert(entity, component.*m_member);
+	}
+
+	std::unique_ptr<IComponentIndex<_TComponent>> Clone() const override
+	{
+		return std::make_unique<HashIndex>(*this);
+	}
+
+private:
+	using Position = details::EntityIdType;
+
+	struct Slot
+	{
+		_TKey Key{};
+		Position BucketPosition = InvalidPosition;
+	};
+
+	static constexpr Position InvalidPosition = std::numeric_limits<Position>::max();
+
+	void Insert(Entity entity, _TKey const& key)
+	{
+		const auto index = entity.Index();
+		if (index >= m_slots.size())
+		{
+			m_slots.resize(index + 1);
+		}
+
+		auto& bucket = m_buckets[key];
+
+		m_slots[index] = Slot{ key, static_cast<Position>(bucket.size()) };
+		bucket.push_back(entity);
+	}
+
+	void Erase(Entity entity)
+	{
+		Slot& slot = m_slots[entity.Index()];
+		assert(slot.BucketPosition != InvalidPosition && "Entity is not indexed");
+
+		auto it = m_buckets.find(slot.Key);
+		auto& bucket = it->second;
+
+		Entity lastEntity = bucket.back();
+		bucket[slot.BucketPosition] = lastEntity;
+		m_slots[lastEntity.Index()].BucketPosition = slot.BucketPosition;
+		bucket.pop_back();
+
+		if (bucket.empty())
+		{
+			m_buckets.erase(it);
+		}
+
+		slot.BucketPosition = InvalidPosition;
+	}
+
+	Member m_member;
+	std::unordered_map<_TKey, std::vector<Entity>> m_buckets;
+	std::vector<Slot> m_slots;
+};
+
+template <typename _TComponent, typename _TKey>
+class SortedIndex final : public IComponentIndex<_TComponent>
+{
+public:
+	using Member = _TKey _TComponent::*;
+
+	explicit SortedIndex(Member member)
+		: m_member(member)
+	{
+	}
+
+	Member GetMember() const
+	{
+		return m_member;
+	}
+
+	Entity FindFirst(_TKey const& key) const
+	{
+		auto it = m_entries.find(key);
+		return it != m_entries.end() ? it->second : InvalidEntity;
+	}
+
+	template <typename _TFunc>
+	void ForEach(_TKey const& key, _TFunc&& func) const
+	{
+		auto [first, last] = m_entries.equal_range(key);
+		for (; first != last; ++first)
+		{
+			func(first->second);
+		}
+	}
+
+	// Visits entities with keys in [min, max] in ascending key order
+	template <typename _TFunc>
+	void ForEachInRange(_TKey const& min, _TKey const& max, _TFunc&& func) const
+	{
+		auto last = m_entries.upper_bound(max);
+		for (auto it = m_entries.lower_bound(min); it != last; ++it)
+		{
+			func(it->second);
+		}
+	}
+
+	void OnComponentAdded(Entity entity, _TComponent const& component) override
+	{
+		const auto index = entity.Index();
+		if (index >= m_slots.size())
+		{
+			m_slots.resize(index + 1);
+		}
+
+		m_slots[index] = m_entries.emplace(component.*m_member, entity);
+	}
+
+	void OnComponentRemoved(Entity entity) override
+	{
+		auto& slot = m_slots[entity.Index()];
+		assert(slot.has_value() && "Entity is not indexed");
+
+		m_entries.erase(*slot);
+		slot.reset();
+	}
+
+	void OnComponentChanged(Entity entity, _TComponent const& component) override
+	{
+		auto& slot = m_slots[entity.Index()];
+		_TKey const& key = component.*m_member;
+
+		if (!((*slot)->first < key) && !(key < (*slot)->first))
+		{
+			return;
+		}
+
+		auto hint = std::next(*slot);
+		m_entries.erase(*slot);
+		slot = m_entries.emplace_hint(hint, key, entity);
+	}
+
+	// Slots point into m_entries, so the copy is rebuilt rather than copied member-wise
+	std::unique_ptr<IComponentIndex<_TComponent>> Clone() const override
+	{
+		auto clone = std::make_unique<SortedIndex>(m_member);
+		clone->m_slots.resize(m_slots.size());
+
+		for (auto const& [key, entity] : m_entries)
+		{
+			clone->m_slots[entity.Index()] = clone->m_entries.emplace_hint(clone->m_entries.end(), key, entity);
+		}
+
+		return clone;
+	}
+
+private:
+	using Entries = std::multimap<_TKey, Entity>;
+
+	Member m_member;
+	Entries m_entries;
+	std::vector<std::optional<typename Entries::iterator>> m_slots;
+};
+
+} // namespace Engine::ecs
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+
+#include "../Entity/Entity.h"
+
+namespace Engine::ecs
+{
+
+// Told about every add, remove and MarkChanged of a pool
+template <typename _TComponent>
+class IComponentListener
+{
+public:
+	virtual ~IComponentListener() = default;
+	virtual void OnComponentAdded(Entity entity, _TComponent const& component) = 0;
+	virtual void OnComponentRemoved(Entity entity) = 0;
+	virtual void OnComponentChanged(Entity entity, _TComponent const& component) = 0;
+};
+
+template <typename _TComponent>
+class IComponentIndex : public IComponentListener<_TComponent>
+{
+public:
+	virtual std::unique_ptr<IComponentIndex> Clone() const = 0;
+};
+
+} // namespace Engine::ecs
@@ -1,10 +1,19 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <istream>
 #include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
 #include <unordered_map>
 
+#include "../BitVector/BitVector.h"
 #include "../ComponentArray/ComponentArray.h"
+#include "../EntityManager/EntityManager.h"
+#include "../Serialization/Serialization.h"
 #include "../TypeIndex/TypeIndex.h"
 
 namespace Engine::ecs
@@ -35,10 +44,98 @@ public:
 	template <typename _TComponent>
 	bool HasComponent(Entity entity) const;
 
+	template <typename _TComponent>
+	std::span<_TComponent> GetComponents();
+
+	template <typename _TComponent>
+	std::span<Entity const> GetEntities() const;
+
+	template <typename _TComponent, typename _TCompare>
+	void Sort(_TCompare compare);
+
+	template <typename _TComponent>
+	void MoveTo(Entity entity, size_t position);
+
+	// Packs the entities owning every listed component into the same leading range of each pool
+	// and keeps them there as components are added and removed. A pool joins one group at most.
+	template <typename... _TComponents>
+	size_t CreateGroup();
+
+	// Length of the leading range of the group owning exactly these components
+	std::optional<size_t> GetGroupSize(Signature owned) const;
+
+	// Packs again the groups owning one of the given components, after their pools were reordered
+	void PackGroups(Signature reordered);
+
+	template <IndexKind _Kind, typename _TComponent, typename _TKey>
+	void CreateIndex(_TKey _TComponent::* member);
+
+	template <typename _TComponent, typename _TKey, typename _TFunc>
+	void VisitIndex(_TKey _TComponent::* member, _TFunc&& func) const;
+
+	template <typename _TComponent>
+	void MarkChanged(std::span<Entity const> entities);
+
+	template <typename _TComponent>
+	void SetJournal(IComponentListener<_TComponent>* journal);
+
+	template <typename _TValue>
+	Shared<_TValue> Intern(_TValue const& value);
+
+	template <typename _TValue>
+	_TValue const& GetSharedValue(Entity entity) const;
+
+	template <typename _TValue>
+	details::SharedTable<_TValue> const& GetSharedTable() const;
+
 	void OnEntityDestroyed(Entity entity);
 
+	std::unique_ptr<ComponentManager> Clone() const;
+
+	// Copies only the pools Serialize writes, without their indices. Pools already in target are
+	// overwritten in place so a target reused between copies stops allocating.
+	void CopySerializableTo(ComponentManager& target) const;
+
+	// Empty pools for every serializable component type
+	std::unique_ptr<ComponentManager> CloneEmpty() const;
+
+	// Adds the serializable components of entities[i] to target as targetEntities[i],
+	// creating pools target doesn't have yet
+	void CopyEntitiesTo(ComponentManager& target, std::span<Entity const> entities, std::span<Entity const> targetEntities) const;
+
+	// Writes every serializable pool tagged with its type key and byte size, with the enable bits
+	// entities holds for its components. The stream must be seekable.
+	void Serialize(std::ostream& stream, EntityManager const& entities) const;
+
+	// Fills registered pools, pools of unregistered types are skipped. Every pool entity has to be
+	// alive in entities, which gets the enable bits of its components.
+	// With a mapping, trivially copyable pools view the mapped file instead of copying it.
+	bool Deserialize(std::istream& stream, EntityManager& entities, std::shared_ptr<details::MappedFile> const& mapping = nullptr);
+
+	template <typename _TFunc>
+	void ForEachArray(_TFunc&& func) const;
+
 private:
+	// Owners are entities with every component of the group, they fill [0, Size) of its pools
+	struct OwningGroup
+	{
+		Signature Owned;
+		size_t Size = 0;
+		bool (*Owns)(ComponentManager const& manager, Entity entity) = nullptr;
+		void (*MoveTo)(ComponentManager& manager, Entity entity, size_t position) = nullptr;
+	};
+
+	// An entity that became an owner is swapped to the end of the range
+	void JoinGroups(Entity entity, Signature added);
+
+	// Called before the components are removed, an owner is swapped out of the range first so the
+	// pool's swap-and-pop doesn't pull a non-owner into it
+	void LeaveGroups(Entity entity, Signature removed);
+
+	void Pack(OwningGroup& group);
+
 	std::unordered_map<ComponentType, std::shared_ptr<IComponentArray>> m_componentArrays;
+	std::vector<OwningGroup> m_groups;
 
 	template <typename _TComponent>
 	std::shared_ptr<ComponentArray<_TComponent>> GetComponentArray() const;
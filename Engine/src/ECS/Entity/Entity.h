@@ -1,11 +1,27 @@
 #pragma once
 #include <cstddef>
+#include <cstdint>
+
+// Define ENGINE_ECS_COMPACT_ENTITY project-wide to store entity handles in 32 bits
+// (20 index bits, 12 generation bits) instead of 64 bits (32/32).
 
 namespace Engine::ecs::details
 {
 
+#ifdef ENGINE_ECS_COMPACT_ENTITY
+using EntityIdType = std::uint32_t;
+
+constexpr std::size_t ENTITY_INDEX_BITS = 20;
+constexpr std::size_t ENTITY_GENERATION_BITS = 12;
+#else
+using EntityIdType = std::uint64_t;
+
 constexpr std::size_t ENTITY_INDEX_BITS = 32;
 constexpr std::size_t ENTITY_GENERATION_BITS = 32;
+#endif
+
+static_assert(ENTITY_INDEX_BITS + ENTITY_GENERATION_BITS == sizeof(EntityIdType) * 8,
+	"Entity index and generation bits must fill the handle exactly");
 
 constexpr std::size_t ENTITY_INDEX_MASK = (1ULL << ENTITY_INDEX_BITS) - 1;
 constexpr std::size_t ENTITY_GENERATION_MASK = (1ULL << ENTITY_GENERATION_BITS) - 1;
@@ -17,7 +33,7 @@ namespace Engine::ecs
 
 struct Entity
 {
-	std::size_t id;
+	details::EntityIdType id;
 
 	operator std::size_t()
 	{
@@ -44,7 +60,7 @@ struct Entity
 
 inline Entity CreateEntity(std::size_t index, std::size_t generation)
 {
-	return Entity{ (generation << details::ENTITY_INDEX_BITS) | index };
+	return Entity{ static_cast<details::EntityIdType>((generation << details::ENTITY_INDEX_BITS) | index) };
 }
 
 constexpr Entity InvalidEntity = Entity{ details::ENTITY_INDEX_MASK };
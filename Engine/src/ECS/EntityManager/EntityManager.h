@@ -1,43 +1,149 @@
 #pragma once
 
 #include <cassert>
-#include <queue>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <limits>
+#include <ostream>
 #include <vector>
 
+#include "../BitVector/BitVector.h"
 #include "../Entity/Entity.h"
 #include "../Entity/Signature.h"
+#include "../Serialization/Serialization.h"
 
 namespace Engine::ecs
 {
 
+enum class RecyclingPolicy
+{
+	// Reuse the index that was freed first, generations grow evenly across slots
+	Fifo,
+	// Reuse the index that was freed last, its record is most likely still in cache
+	Lifo,
+};
+
+enum class GenerationOverflow
+{
+	// Slot is never handed out again once its generation is exhausted
+	Retire,
+	// Generation starts over from zero, stale handles may alias new entities
+	Wrap,
+};
+
 class EntityManager final
 {
 public:
+	explicit EntityManager(
+		RecyclingPolicy recycling = RecyclingPolicy::Fifo,
+		GenerationOverflow overflow = GenerationOverflow::Retire);
+
 	[[nodiscard]] Entity CreateEntity();
 
 	void DestroyEntity(Entity entity);
 
+	bool IsAlive(Entity entity) const;
+
 	void SetSignature(Entity entity, Signature const& signature);
 
 	Signature& GetSignature(Entity entity);
 
 	Signature const& GetSignature(Entity entity) const;
 
+	void SetEnabled(Entity entity, bool enabled);
+
+	bool IsEnabled(Entity entity) const;
+
+	void SetComponentEnabled(Entity entity, std::size_t componentType, bool enabled);
+
+	bool IsComponentEnabled(Entity entity, std::size_t componentType) const;
+
+	// Gives entity the enable state of sourceEntity and of each of its components
+	void CopyEnabledState(Entity entity, EntityManager const& source, Entity sourceEntity);
+
+	// Components of the entity views must skip, every bit is set while the entity itself is disabled
+	Signature GetDisabledSignature(Entity entity) const;
+
 	[[nodiscard]] std::vector<Entity> const& GetActiveEntities() const;
 
+	[[nodiscard]] std::size_t GetRetiredCount() const;
+
+	// Entity indices handed out so far, whether their entities are alive, dead or retired
+	[[nodiscard]] std::size_t GetIndexCount() const;
+
+	// Generations, free list and active entities; component masks are rebuilt by the scene on load
+	void Serialize(std::ostream& stream) const;
+
+	// Expects a manager that has never created an entity
+	bool Deserialize(std::istream& stream);
+
+	// Undo log of CreateEntity and DestroyEntity used by the frame history.
+	// Positions are absolute and stay valid after older entries are discarded.
+	void SetJournaling(bool enabled);
+
+	std::size_t GetJournalPosition() const;
+
+	// Undoes every entry logged after position, restoring indices, generations and the free list.
+	// Revived entities come back without components, the caller restores those.
+	void RewindJournal(std::size_t position);
+
+	// Forgets entries logged before position
+	void DiscardJournal(std::size_t position);
+
 private:
+	using IndexType = std::uint32_t;
+
+	struct EntityRecord
+	{
+		Signature ComponentMask;
+		// Components disabled one by one, kept while the whole entity is disabled
+		Signature DisabledMask;
+		bool Disabled = false;
+		IndexType Generation = 0;
+		// Position in m_activeEntities while alive, next free index while dead
+		IndexType Link = 0;
+	};
+
+	struct JournalEntry
+	{
+		Entity Target = InvalidEntity;
+		bool Created = false;
+		// CreateEntity appended a new record instead of recycling one
+		bool Grew = false;
+		EntityRecord Record;
+		IndexType FreeHead = 0;
+		IndexType FreeTail = 0;
+		IndexType FreeTailLink = 0;
+		std::size_t RetiredCount = 0;
+	};
+
+	static constexpr IndexType NullIndex = std::numeric_limits<IndexType>::max();
+	static constexpr IndexType RetiredGeneration = static_cast<IndexType>(details::ENTITY_GENERATION_MASK);
+
 	bool IsValid(Entity entity) const;
 
+	void PushFree(IndexType index);
+
+	IndexType PopFree();
+
+	JournalEntry MakeJournalEntry(Entity entity, bool created) const;
+
 private:
-	TypeIndexType m_nextEntityIndex = 0;
-	std::queue<TypeIndexType> m_availableIndices;
+	RecyclingPolicy m_recycling;
+	GenerationOverflow m_overflow;
 
-	std::vector<TypeIndexType> m_generations;
+	std::vector<EntityRecord> m_records;
 
-	std::vector<Signature> m_signatures;
+	IndexType m_freeHead = NullIndex;
+	IndexType m_freeTail = NullIndex;
+	std::size_t m_retiredCount = 0;
 
 	std::vector<Entity> m_activeEntities;
-	std::vector<size_t> m_entityLocations;
+
+	bool m_journaling = false;
+	std::deque<JournalEntry> m_journal;
+	std::size_t m_journalBase = 0;
 };
 
 } // namespace Engine::ecs
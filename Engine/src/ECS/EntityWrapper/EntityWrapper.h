@@ -30,13 +30,13 @@ public:
 	template <typename _TComponent>
 	void AddComponent(_TComponent const& component)
 	{
-		m_scene->AddComponent<_TComponent>(m_id, component);
+		m_scene->template AddComponent<_TComponent>(m_id, component);
 	}
 
 	template <typename _TComponent, typename... _TArgs>
 	void AddComponent(_TArgs&&... args)
 	{
-		m_scene->AddComponent<_TComponent>(
+		m_scene->template AddComponent<_TComponent>(
 			m_id,
 			_TComponent{ std::forward<_TArgs>(args)... });
 	}
@@ -44,25 +44,36 @@ public:
 	template <typename _TComponent>
 	_TComponent& GetComponent()
 	{
-		return m_scene->GetComponent<_TComponent>(m_id);
+		return m_scene->template GetComponent<_TComponent>(m_id);
 	}
 
 	template <typename _TComponent>
 	_TComponent const& GetComponent() const
 	{
-		return m_scene->GetComponent<_TComponent>(m_id);
+		return m_scene->template GetComponent<_TComponent>(m_id);
 	}
 
 	template <typename _TComponent>
 	bool HasComponent() const
 	{
-		return m_scene->HasComponent<_TComponent>(m_id);
+		return m_scene->template HasComponent<_TComponent>(m_id);
 	}
 
 	template <typename _TComponent>
 	void RemoveComponent()
 	{
-		m_scene->RemoveComponent<_TComponent>(m_id);
+		m_scene->template RemoveComponent<_TComponent>(m_id);
+	}
+
+	template <typename _TComponent>
+	void SetComponentEnabled(bool enabled)
+	{
+		m_scene->template SetComponentEnabled<_TComponent>(m_id, enabled);
+	}
+
+	void SetEnabled(bool enabled)
+	{
+		m_scene->SetEntityEnabled(m_id, enabled);
 	}
 
 	void Destroy()
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../ComponentArray/ComponentArray.h"
+#include "../ComponentIndex/IComponentIndex.h"
+#include "../ComponentManager/ComponentManager.h"
+#include "../Entity/Entity.h"
+#include "../Shared/Shared.h"
+
+namespace Engine::ecs
+{
+
+template <typename _TScene>
+class IComponentHistory
+{
+public:
+	virtual ~IComponentHistory() = default;
+
+	// Stores the changes journaled since the last frame in slot
+	virtual void Record(_TScene& scene, std::size_t slot) = 0;
+
+	// Reverts the changes stored in slot, entities must already be rewound
+	virtual void Undo(_TScene& scene, std::size_t slot) = 0;
+};
+
+// Journals the entities whose component was added, removed or marked changed in the pool, so
+// recording a frame only visits those
+template <typename _TScene, typename _TComponent>
+class ComponentHistory final : public IComponentHistory<_TScene>, public IComponentListener<_TComponent>
+{
+	static_assert(!details::IsShared<_TComponent>, "Shared components can't be tracked by the frame history");
+
+public:
+	ComponentHistory(_TScene& scene, std::size_t frameCount)
+		: m_components(scene.GetComponentManager())
+		, m_frames(frameCount)
+	{
+		auto components = scene.template GetComponents<_TComponent>();
+		auto entities = scene.template GetComponentEntities<_TComponent>();
+
+		for (std::size_t i = 0; i < components.size(); ++i)
+		{
+			m_committed.AddComponent(entities[i], components[i]);
+		}
+
+		m_components.template SetJournal<_TComponent>(this);
+	}
+
+	~ComponentHistory() override
+	{
+		m_components.template SetJournal<_TComponent>(nullptr);
+	}
+
+	ComponentHistory(ComponentHistory const&) = delete;
+	ComponentHistory& operator=(ComponentHistory const&) = delete;
+
+	void OnComponentAdded(Entity entity, _TComponent const&) override
+	{
+		Journal(entity);
+	}
+
+	void OnComponentRemoved(Entity entity) override
+	{
+		Journal(entity);
+	}
+
+	void OnComponentChanged(Entity entity, _TComponent const&) override
+	{
+		Journal(entity);
+	}
+
+	void Record(_TScene& scene, std::size_t slot) override
+	{
+		FrameDelta& delta = m_frames[slot];
+		delta.Added.clear();
+		delta.Changed.clear();
+		delta.Removed.clear();
+
+		// Removals first: an entity index destroyed and reused within the frame must leave its old
+		// entry before the new entity claims the index
+		for (Entity entity : m_journal)
+		{
+			if (m_committed.HasComponent(entity) && !scene.template HasComponent<_TComponent>(entity))
+			{
+				delta.Removed.emplace_back(entity, m_committed.GetComponent(entity));
+				m_committed.RemoveComponent(entity);
+			}
+		}
+
+		for (Entity entity : m_journal)
+		{
+			if (!scene.template HasComponent<_TComponent>(entity))
+			{
+				continue;
+			}
+
+			auto const& component = scene.template GetComponent<_TComponent>(entity);
+			if (!m_committed.HasComponent(entity))
+			{
+				delta.Added.push_back(entity);
+				m_committed.AddComponent(entity, component);
+			}
+			else if (auto& committed = m_committed.GetComponent(entity); !Equal(committed, component))
+			{
+				delta.Changed.emplace_back(entity, committed);
+				committed = component;
+			}
+		}
+
+		ClearJournal();
+	}
+
+	void Undo(_TScene& scene, std::size_t slot) override
+	{
+		FrameDelta& delta = m_frames[slot];
+
+		for (Entity entity : delta.Added)
+		{
+			if (scene.template HasComponent<_TComponent>(entity))
+			{
+				scene.template RemoveComponent<_TComponent>(entity);
+			}
+			m_committed.RemoveComponent(entity);
+		}
+
+		for (auto const& [entity, value] : delta.Removed)
+		{
+			scene.template AddComponent<_TComponent>(entity, value);
+			m_committed.AddComponent(entity, value);
+		}
+
+		for (auto const& [entity, value] : delta.Changed)
+		{
+			scene.template GetComponent<_TComponent>(entity) = value;
+			scene.template MarkChanged<_TComponent>(entity);
+			m_committed.GetComponent(entity) = value;
+		}
+
+		// What the rewind and the lines above journaled is already committed
+		ClearJournal();
+	}
+
+private:
+	struct FrameDelta
+	{
+		std::vector<Entity> Added;
+		std::vector<std::pair<Entity, _TComponent>> Changed;
+		std::vector<std::pair<Entity, _TComponent>> Removed;
+	};
+
+	static bool Equal(_TComponent const& lhs, _TComponent const& rhs)
+	{
+		if constexpr (std::equality_comparable<_TComponent>)
+		{
+			return lhs == rhs;
+		}
+		else
+		{
+			static_assert(std::is_trivially_copyable_v<_TComponent>,
+				"Tracked components need operator== or must be trivially copyable");
+			return std::memcmp(&lhs, &rhs, sizeof(_TComponent)) == 0;
+		}
+	}
+
+	void Journal(Entity entity)
+	{
+		const std::size_t index = entity.Index();
+		if (index >= m_journaled.size())
+		{
+			m_journaled.resize(index + 1, InvalidEntity);
+		}
+
+		if (m_journaled[index] != entity)
+		{
+			m_journaled[index] = entity;
+			m_journal.push_back(entity);
+		}
+	}
+
+	void ClearJournal()
+	{
+		for (Entity entity : m_journal)
+		{
+			m_journaled[entity.Index()] = InvalidEntity;
+		}
+		m_journal.clear();
+	}
+
+	ComponentManager& m_components;
+	// Values as of the last recorded frame. A mark comes after the write, so the value a change
+	// replaced is only known from here. Only journaled entities are looked at.
+	ComponentArray<_TComponent> m_committed;
+	// Entities journaled in the open frame, m_journaled holds them by index to skip repeats
+	std::vector<Entity> m_journal;
+	std::vector<Entity> m_journaled;
+	std::vector<FrameDelta> m_frames;
+};
+
+// Fixed-size ring of per-frame deltas. A frame is closed by Scene::ConfirmChanges,
+// the oldest one is overwritten once the ring is full.
+template <typename _TScene>
+class FrameHistory final
+{
+public:
+	struct Frame
+	{
+		// EntityManager journal position when the frame began
+		std::size_t JournalPosition = 0;
+		std::vector<Entity> Created;
+	};
+
+	FrameHistory(std::size_t capacity, std::size_t journalPosition)
+		: m_frames(capacity)
+		, m_openPosition(journalPosition)
+	{
+		assert(capacity > 0 && "Frame history needs room for at least one frame");
+	}
+
+	template <typename _TComponent>
+	void Track(_TScene& scene)
+	{
+		m_components.push_back(std::make_unique<ComponentHistory<_TScene, _TComponent>>(scene, m_frames.size()));
+	}
+
+	void OnEntityCreated(Entity entity)
+	{
+		m_openCreated.push_back(entity);
+	}
+
+	void Commit(_TScene& scene, std::size_t journalPosition)
+	{
+		const std::size_t slot = m_next;
+
+		Frame& frame = m_frames[slot];
+		frame.JournalPosition = m_openPosition;
+		std::swap(frame.Created, m_openCreated);
+		m_openCreated.clear();
+
+		for (auto const& component : m_components)
+		{
+			component->Record(scene, slot);
+		}
+
+		m_next = (slot + 1) % m_frames.size();
+		m_count = std::min(m_count + 1, m_frames.size());
+		m_openPosition = journalPosition;
+	}
+
+	// Pops the newest frame. rewindEntities(frame) runs before component changes are reverted.
+	template <typename _TFunc>
+	void UndoNewest(_TScene& scene, _TFunc&& rewindEntities)
+	{
+		assert(m_count > 0 && "No recorded frames left");
+		assert(m_openCreated.empty() && "Rollback must directly follow ConfirmChanges");
+
+		m_next = (m_next + m_frames.size() - 1) % m_frames.size();
+		m_count--;
+
+		Frame const& frame = m_frames[m_next];
+		rewindEntities(frame);
+
+		for (auto const& component : m_components)
+		{
+			component->Undo(scene, m_next);
+		}
+
+		m_openPosition = frame.JournalPosition;
+	}
+
+	std::size_t GetFrameCount() const
+	{
+		return m_count;
+	}
+
+	// Journal entries before this position are no longer reachable by a rollback
+	std::size_t GetOldestJournalPosition() const
+	{
+		if (m_count == 0)
+		{
+			return m_openPosition;
+		}
+
+		return m_frames[(m_next + m_frames.size() - m_count) % m_frames.size()].JournalPosition;
+	}
+
+private:
+	std::vector<Frame> m_frames;
+	std::size_t m_next = 0;
+	std::size_t m_count = 0;
+
+	std::size_t m_openPosition;
+	std::vector<Entity> m_openCreated;
+
+	std::vector<std::unique_ptr<IComponentHistory<_TScene>>> m_components;
+};
+
+} // namespace Engine::ecs
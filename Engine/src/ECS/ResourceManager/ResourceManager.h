@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <memory>
+#include <vector>
+
+#include "../TypeIndex/TypeIndex.h"
+
+namespace Engine::ecs
+{
+using ResourceId = TypeIndexType;
+
+// Scene-wide singletons (camera, input, time) addressed by a dense per-type slot
+class ResourceManager final
+{
+public:
+	template <typename _TResource, typename... _TArgs>
+	_TResource& SetResource(_TArgs&&... args);
+
+	template <typename _TResource>
+	void RemoveResource();
+
+	template <typename _TResource>
+	bool HasResource() const;
+
+	template <typename _TResource>
+	_TResource& GetResource();
+
+	template <typename _TResource>
+	_TResource const& GetResource() const;
+
+	// Resources that cannot be copied are left out of the clone
+	std::unique_ptr<ResourceManager> Clone() const;
+
+private:
+	class IResourceSlot
+	{
+	public:
+		virtual ~IResourceSlot() = default;
+		virtual std::unique_ptr<IResourceSlot> Clone() const = 0;
+	};
+
+	template <typename _TResource>
+	class ResourceSlot final : public IResourceSlot
+	{
+	public:
+		template <typename... _TArgs>
+		explicit ResourceSlot(_TArgs&&... args)
+			: Value{ std::forward<_TArgs>(args)... }
+		{
+		}
+
+		std::unique_ptr<IResourceSlot> Clone() const override
+		{
+			if constexpr (std::copy_constructible<_TResource>)
+			{
+				return std::make_unique<ResourceSlot>(Value);
+			}
+			else
+			{
+				return nullptr;
+			}
+		}
+
+		_TResource Value;
+	};
+
+	std::vector<std::unique_ptr<IResourceSlot>> m_slots;
+};
+
+} // namespace Engine::ecs
+
+#include "ResourceManager.impl"
@@ -1,11 +1,30 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <istream>
 #include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <system_error>
 #include <vector>
 
 #include "../ComponentManager/ComponentManager.h"
 #include "../Entity/Entity.h"
 #include "../EntityManager/EntityManager.h"
+#include "../History/FrameHistory.h"
+#include "../ResourceManager/ResourceManager.h"
+#include "../Serialization/EntityBatch.h"
+#include "../Serialization/SaveTask.h"
+#include "../Serialization/SceneFile.h"
+#include "../Serialization/Serialization.h"
 #include "../SystemManager/SystemManager.h"
 #include "../ViewManager/ViewManager.h"
 
@@ -16,16 +35,47 @@ class Scene
 {
 public:
 	Scene()
+		: Scene(RecyclingPolicy::Fifo)
+	{
+	}
+
+	explicit Scene(RecyclingPolicy recycling, GenerationOverflow overflow = GenerationOverflow::Retire)
 		: m_componentManager(std::make_unique<ComponentManager>())
-		, m_entityManager(std::make_unique<EntityManager>())
+		, m_entityManager(std::make_unique<EntityManager>(recycling, overflow))
 		, m_systemManager(std::make_unique<SystemManager>())
 		, m_viewManager(std::make_unique<ViewManager>())
+		, m_resourceManager(std::make_unique<ResourceManager>())
+	{
+	}
+
+	// Copies entities, components and resources into an independent scene for speculative updates.
+	// Views are rebuilt on demand, systems are copied or recreated as described in
+	// SystemManager::Clone. A recreated system starts without the state it kept between frames, so
+	// the clone can diverge from the source on its first step unless the system implements Clone.
+	std::unique_ptr<Scene> Clone() const
 	{
+		auto clone = std::unique_ptr<Scene>(new Scene(
+			m_componentManager->Clone(),
+			std::make_unique<EntityManager>(*m_entityManager),
+			m_resourceManager->Clone()));
+
+		clone->m_entityManager->SetJournaling(false);
+		clone->m_systemManager = m_systemManager->Clone(clone.get());
+		clone->m_entitiesToDestroy = m_entitiesToDestroy;
+
+		return clone;
 	}
 
 	Entity CreateEntity()
 	{
-		return m_entityManager->CreateEntity();
+		Entity entity = m_entityManager->CreateEntity();
+
+		if (m_history)
+		{
+			m_history->OnEntityCreated(entity);
+		}
+
+		return entity;
 	}
 
 	void DestoryEntity(Entity entity)
@@ -69,16 +119,59 @@ public:
 		AddComponentImpl(entity, std::move(component));
 	}
 
+	template <typename _TValue>
+	void AddSharedComponent(Entity entity, _TValue const& value)
+	{
+		AddComponentImpl(entity, m_componentManager->Intern(value));
+	}
+
+	template <typename _TValue>
+	_TValue const& GetSharedComponent(Entity entity) const
+	{
+		return m_componentManager->GetSharedValue<_TValue>(entity);
+	}
+
 	template <typename _TComponent>
 	void RemoveComponent(Entity entity)
 	{
 		m_componentManager->RemoveComponent<_TComponent>(entity);
 
 		auto& signature = m_entityManager->GetSignature(entity);
-		signature.set(TypeIndex<_TComponent>());
+		signature.reset(TypeIndex<_TComponent>());
 		m_entityManager->SetSignature(entity, signature);
+		m_entityManager->SetComponentEnabled(entity, TypeIndex<_TComponent>(), true);
+
+		NotifySignatureChanged(entity);
+	}
+
+	// Systems and views skip entities while a component they need is disabled
+	template <typename _TComponent>
+	void SetComponentEnabled(Entity entity, bool enabled)
+	{
+		assert(HasComponent<_TComponent>(entity) && "Entity does not have component of this type");
+		m_entityManager->SetComponentEnabled(entity, TypeIndex<_TComponent>(), enabled);
+
+		NotifySignatureChanged(entity);
+	}
+
+	template <typename _TComponent>
+	bool IsComponentEnabled(Entity entity) const
+	{
+		assert(HasComponent<_TComponent>(entity) && "Entity does not have component of this type");
+		return m_entityManager->IsComponentEnabled(entity, TypeIndex<_TComponent>());
+	}
+
+	// Systems and views skip disabled entities
+	void SetEntityEnabled(Entity entity, bool enabled)
+	{
+		m_entityManager->SetEnabled(entity, enabled);
+
+		NotifySignatureChanged(entity);
+	}
 
-		m_systemManager->OnEntitySignatureChanged(entity, signature, this);
+	bool IsEntityEnabled(Entity entity) const
+	{
+		return m_entityManager->IsEnabled(entity);
 	}
 
 	template <typename _TComponent>
@@ -99,6 +192,149 @@ public:
 		return m_componentManager->HasComponent<_TComponent>(entity);
 	}
 
+	template <typename _TComponent>
+	std::span<_TComponent> GetComponents()
+	{
+		return m_componentManager->GetComponents<_TComponent>();
+	}
+
+	template <typename _TComponent>
+	std::span<Entity const> GetComponentEntities() const
+	{
+		return m_componentManager->GetEntities<_TComponent>();
+	}
+
+	template <typename _TComponent, typename _TCompare>
+	void Sort(_TCompare compare)
+	{
+		m_componentManager->Sort<_TComponent>(std::move(compare));
+		m_componentManager->PackGroups(Signature().set(TypeIndex<_TComponent>()));
+		m_viewManager->OnComponentsReordered();
+	}
+
+	// Moves entities to the front of every listed pool in the given order, so component i of each
+	// pool belongs to entities[i]. Every entity needs all the listed components. Grouped pools
+	// are packed again afterwards.
+	template <typename... _TComponents>
+	void Order(std::span<Entity const> entities)
+	{
+		for (size_t i = 0; i < entities.size(); ++i)
+		{
+			(m_componentManager->MoveTo<_TComponents>(entities[i], i), ...);
+		}
+
+		m_componentManager->PackGroups((Signature().set(TypeIndex<_TComponents>()) | ...));
+		m_viewManager->OnComponentsReordered();
+	}
+
+	// Packs entities owning every listed component into the same leading dense range of each pool,
+	// returns the length of that range. Component i of GetComponents<A>() then belongs to the
+	// same entity as component i of GetComponents<B>(). The range is kept packed as components
+	// are added and removed, and View<_TComponents...> walks it by dense index. A pool can be
+	// owned by one group only, calling Group again for the same components returns the current size.
+	template <typename... _TComponents>
+	size_t Group()
+	{
+		static_assert(sizeof...(_TComponents) > 1, "Group needs at least two component types");
+
+		if (auto size = m_componentManager->GetGroupSize((Signature().set(TypeIndex<_TComponents>()) | ...)))
+		{
+			return *size;
+		}
+
+		const size_t groupSize = m_componentManager->CreateGroup<_TComponents...>();
+		m_viewManager->OnComponentsReordered();
+
+		return groupSize;
+	}
+
+	// The kind is a template argument so a key type that can't back it fails to compile
+	template <IndexKind _Kind = IndexKind::Hash, typename _TComponent, typename _TKey>
+	void CreateIndex(_TKey _TComponent::* member)
+	{
+		m_componentManager->CreateIndex<_Kind>(member);
+	}
+
+	// Call after writing a component through GetComponent, indices, the frame history and the
+	// systems holding the entity see the new value from then on
+	template <typename _TComponent>
+	void MarkChanged(Entity entity)
+	{
+		MarkChanged<_TComponent>(std::span<Entity const>(&entity, 1));
+	}
+
+	template <typename _TComponent>
+	void MarkChanged(std::span<Entity const> entities)
+	{
+		m_componentManager->MarkChanged<_TComponent>(entities);
+		m_systemManager->OnComponentChanged(entities, TypeIndex<_TComponent>());
+	}
+
+	template <typename _TComponent, typename _TKey>
+	Entity FindBy(_TKey _TComponent::* member, std::type_identity_t<_TKey> const& value) const
+	{
+		Entity result = InvalidEntity;
+		m_componentManager->VisitIndex(member, [&](auto const& index) {
+			result = index.FindFirst(value);
+		});
+
+		return result;
+	}
+
+	template <typename _TComponent, typename _TKey, typename _TFunc>
+	void ForEachBy(_TKey _TComponent::* member, std::type_identity_t<_TKey> const& value, _TFunc&& func) const
+	{
+		m_componentManager->VisitIndex(member, [&](auto const& index) {
+			index.ForEach(value, func);
+		});
+	}
+
+	template <typename _TComponent, typename _TKey, typename _TFunc>
+	void ForEachInRangeBy(_TKey _TComponent::* member,
+		std::type_identity_t<_TKey> const& min, std::type_identity_t<_TKey> const& max, _TFunc&& func) const
+	{
+		m_componentManager->VisitIndex(member, [&](auto const& index) {
+			if constexpr (requires { index.ForEachInRange(min, max, func); })
+			{
+				index.ForEachInRange(min, max, func);
+			}
+			else
+			{
+				assert(false && "Range queries need an IndexKind::Sorted index");
+			}
+		});
+	}
+
+	template <typename _TResource, typename... _TArgs>
+	_TResource& SetResource(_TArgs&&... args)
+	{
+		return m_resourceManager->SetResource<_TResource>(std::forward<_TArgs>(args)...);
+	}
+
+	template <typename _TResource>
+	void RemoveResource()
+	{
+		m_resourceManager->RemoveResource<_TResource>();
+	}
+
+	template <typename _TResource>
+	bool HasResource() const
+	{
+		return m_resourceManager->HasResource<_TResource>();
+	}
+
+	template <typename _TResource>
+	_TResource& GetResource()
+	{
+		return m_resourceManager->GetResource<_TResource>();
+	}
+
+	template <typename _TResource>
+	_TResource const& GetResource() const
+	{
+		return m_resourceManager->GetResource<_TResource>();
+	}
+
 	template <typename _TSystem, typename... _TArgs>
 	SystemManager::SystemConfiguration RegisterSystem(_TArgs&&... args)
 	{
@@ -121,6 +357,12 @@ public:
 		m_systemManager->Execute(*this, dt);
 	}
 
+	template <typename _TFunc>
+	void ParallelFor(size_t count, size_t grainSize, _TFunc&& func)
+	{
+		m_systemManager->ParallelFor(count, grainSize, std::forward<_TFunc>(func));
+	}
+
 	ComponentManager& GetComponentManager() const
 	{
 		return *m_componentManager;
@@ -132,11 +374,185 @@ public:
 		{
 			m_entityManager->DestroyEntity(entity);
 			m_componentManager->OnEntityDestroyed(entity);
-			m_systemManager->OnEntitySignatureChanged(entity, {}, this);
+			m_systemManager->OnEntitySignatureChanged(entity, {}, {}, this);
 			m_viewManager->OnEntityDestroyed(entity);
 		}
 
 		m_entitiesToDestroy.clear();
+
+		InsertQueuedBatches();
+		RunDeferred();
+
+		if (m_history)
+		{
+			m_history->Commit(*this, m_entityManager->GetJournalPosition());
+			m_entityManager->DiscardJournal(m_history->GetOldestJournalPosition());
+		}
+	}
+
+	// Starts recording the listed components at every ConfirmChanges, keeping the last frameCount frames.
+	// Only adds, removals and MarkChanged are recorded, a write without MarkChanged isn't undone.
+	template <typename... _TComponents>
+	void EnableHistory(size_t frameCount)
+	{
+		m_entityManager->SetJournaling(true);
+		m_history.reset();
+		m_history = std::make_unique<FrameHistory<Scene>>(frameCount, m_entityManager->GetJournalPosition());
+		(m_history->Track<_TComponents>(*this), ...);
+	}
+
+	size_t GetHistoryFrameCount() const
+	{
+		return m_history ? m_history->GetFrameCount() : 0;
+	}
+
+	// Restores the state of `frames` ConfirmChanges ago in time proportional to what changed since.
+	// Entities come back with their original handles, but only tracked components are restored.
+	void Rollback(size_t frames)
+	{
+		assert(m_history && frames <= m_history->GetFrameCount() && "Not enough frames recorded");
+
+		for (size_t i = 0; i < frames; ++i)
+		{
+			m_history->UndoNewest(*this, [this](auto const& frame) {
+				for (Entity entity : frame.Created)
+				{
+					if (m_entityManager->IsAlive(entity))
+					{
+						m_componentManager->OnEntityDestroyed(entity);
+						m_systemManager->OnEntitySignatureChanged(entity, {}, {}, this);
+						m_viewManager->OnEntityDestroyed(entity);
+					}
+				}
+
+				m_entityManager->RewindJournal(frame.JournalPosition);
+			});
+		}
+	}
+
+	// Writes entities and every serializable component pool. Resources and systems are not saved.
+	bool Save(std::ostream& stream) const
+	{
+		return details::WriteSceneFile(stream, *m_entityManager, *m_componentManager);
+	}
+
+	// Written next to path and renamed once complete, so a scene loaded with LoadMapped from path
+	// keeps its pages and path never holds a partial scene
+	bool Save(std::filesystem::path const& path) const
+	{
+		return WriteThenRename(path, [&](std::ostream& stream) {
+			return Save(stream);
+		});
+	}
+
+	// Call after ConfirmChanges. Copies entities and serializable pools, then writes the copy on a
+	// separate thread while the scene keeps running. The copy is kept for the next save and reused
+	// when that save is finished, so repeated saves only pay for a memcpy of the pools.
+	// The file is written next to path and renamed once complete, path never holds a partial scene.
+	// The scene keeps the save alive until it is written, the handle is only needed for the result.
+	[[nodiscard]] SaveTask SaveAsync(std::filesystem::path const& path)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		// Still referenced while an earlier save is writing it
+		if (!m_saveSnapshot || m_saveSnapshot.use_count() > 1)
+		{
+			m_saveSnapshot = std::make_shared<SaveSnapshot>();
+		}
+		// Pairs with the release of the writer thread's reference
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		m_saveSnapshot->Entities = *m_entityManager;
+		m_componentManager->CopySerializableTo(m_saveSnapshot->Components);
+
+		const auto pause = std::chrono::steady_clock::now() - start;
+
+		SaveTask task(pause, [path, snapshot = m_saveSnapshot]() {
+			return WriteThenRename(path, [&](std::ostream& stream) {
+				return details::WriteSceneFile(stream, snapshot->Entities, snapshot->Components);
+			});
+		});
+
+		std::erase_if(m_pendingSaves, [](SaveTask const& pending) {
+			return pending.IsDone();
+		});
+		m_pendingSaves.push_back(task);
+
+		return task;
+	}
+
+	// Loads into a scene without entities whose components are already registered.
+	// Returns false on a format mismatch or truncated data, the scene is then unusable.
+	bool Load(std::istream& stream)
+	{
+		return LoadImpl(stream, nullptr);
+	}
+
+	bool Load(std::filesystem::path const& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		return file && Load(file);
+	}
+
+	// Like Load, but maps the file copy-on-write and points trivially copyable pools at its pages.
+	// Unmodified pages are shared with other processes that map the same file; a pool moves to
+	// owned memory when it first grows.
+	bool LoadMapped(std::filesystem::path const& path)
+	{
+		auto mapping = details::MappedFile::Open(path);
+		if (!mapping)
+		{
+			return false;
+		}
+
+		details::MemoryStreamBuffer buffer(mapping->Data(), mapping->Size());
+		std::istream stream(&buffer);
+
+		return LoadImpl(stream, mapping);
+	}
+
+	// Copies the entities and their serializable components into a batch, the entities stay in the scene
+	EntityBatch CopyToBatch(std::span<Entity const> entities) const
+	{
+		EntityBatch batch = CreateBatch();
+
+		std::vector<Entity> batchEntities;
+		batchEntities.reserve(entities.size());
+
+		for (Entity entity : entities)
+		{
+			batchEntities.push_back(batch.Entities->CreateEntity());
+			batch.Entities->CopyEnabledState(batchEntities.back(), *m_entityManager, entity);
+		}
+
+		m_componentManager->CopyEntitiesTo(*batch.Components, entities, batchEntities);
+
+		return batch;
+	}
+
+	// Empty batch with a pool for every serializable component, ready for EntityBatch::Read.
+	// Reading the batch doesn't touch the scene and can run on any thread.
+	EntityBatch CreateBatch() const
+	{
+		EntityBatch batch;
+		batch.Components = m_componentManager->CloneEmpty();
+
+		return batch;
+	}
+
+	// Can be called from any thread. The entities are created in bulk by the next ConfirmChanges.
+	void QueueBatch(EntityBatch batch)
+	{
+		std::lock_guard<std::mutex> lock(m_batchMutex);
+		m_queuedBatches.push_back(std::move(batch));
+	}
+
+	// Can be called from any thread, systems included. func runs in the next ConfirmChanges after
+	// queued batches are inserted, where structural changes such as reordering pools are safe.
+	void Defer(std::function<void(Scene&)> func)
+	{
+		std::lock_guard<std::mutex> lock(m_deferredMutex);
+		m_deferred.push_back(std::move(func));
 	}
 
 	template <typename... _TComponents>
@@ -146,6 +562,132 @@ public:
 	}
 
 private:
+	Scene(std::unique_ptr<ComponentManager> componentManager,
+		std::unique_ptr<EntityManager> entityManager,
+		std::unique_ptr<ResourceManager> resourceManager)
+		: m_componentManager(std::move(componentManager))
+		, m_entityManager(std::move(entityManager))
+		, m_viewManager(std::make_unique<ViewManager>())
+		, m_resourceManager(std::move(resourceManager))
+	{
+	}
+
+	void InsertQueuedBatches()
+	{
+		std::vector<EntityBatch> batches;
+		{
+			std::lock_guard<std::mutex> lock(m_batchMutex);
+			std::swap(batches, m_queuedBatches);
+		}
+
+		for (EntityBatch& batch : batches)
+		{
+			InsertBatch(batch);
+		}
+	}
+
+	// Writes path + ".tmp" and renames it over path once write succeeded
+	template <typename _TWrite>
+	static bool WriteThenRename(std::filesystem::path const& path, _TWrite&& write)
+	{
+		std::filesystem::path temporary = path;
+		temporary += ".tmp";
+
+		{
+			std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+			if (!file || !write(file) || !file.flush())
+			{
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporary, path, error);
+		return !error;
+	}
+
+	void RunDeferred()
+	{
+		std::vector<std::function<void(Scene&)>> deferred;
+		{
+			std::lock_guard<std::mutex> lock(m_deferredMutex);
+			std::swap(deferred, m_deferred);
+		}
+
+		for (auto& func : deferred)
+		{
+			func(*this);
+		}
+	}
+
+	void InsertBatch(EntityBatch& batch)
+	{
+		auto const& batchEntities = batch.Entities->GetActiveEntities();
+
+		std::vector<Entity> entities;
+		entities.reserve(batchEntities.size());
+
+		// Batch handles are remapped by index, generations don't matter inside a batch
+		std::vector<Entity> remap;
+		for (Entity batchEntity : batchEntities)
+		{
+			const Entity entity = CreateEntity();
+			entities.push_back(entity);
+
+			if (batchEntity.Index() >= remap.size())
+			{
+				remap.resize(batchEntity.Index() + 1, InvalidEntity);
+			}
+			remap[batchEntity.Index()] = entity;
+
+			m_entityManager->CopyEnabledState(entity, *batch.Entities, batchEntity);
+		}
+
+		// One pass per pool instead of one pool lookup per component
+		batch.Components->CopyEntitiesTo(*m_componentManager, batchEntities, entities);
+
+		batch.Components->ForEachArray([&](ComponentType type, IComponentArray const& array) {
+			for (Entity batchEntity : array.GetEntities())
+			{
+				m_entityManager->GetSignature(remap[batchEntity.Index()]).set(type);
+			}
+		});
+
+		for (Entity entity : entities)
+		{
+			NotifySignatureChanged(entity);
+		}
+
+		if (batch.OnInserted)
+		{
+			batch.OnInserted(entities);
+		}
+	}
+
+	bool LoadImpl(std::istream& stream, std::shared_ptr<details::MappedFile> const& mapping)
+	{
+		assert(m_entityManager->GetActiveEntities().empty() && "Scenes can only be loaded into an empty scene");
+
+		if (!details::ReadSceneFile(stream, *m_entityManager, *m_componentManager, mapping))
+		{
+			return false;
+		}
+
+		m_componentManager->ForEachArray([this](ComponentType type, IComponentArray const& array) {
+			for (Entity entity : array.GetEntities())
+			{
+				m_entityManager->GetSignature(entity).set(type);
+			}
+		});
+
+		for (Entity entity : m_entityManager->GetActiveEntities())
+		{
+			NotifySignatureChanged(entity);
+		}
+
+		return true;
+	}
+
 	template <typename _TComponent>
 	void AddComponentImpl(Entity entity, _TComponent component)
 	{
@@ -155,17 +697,44 @@ private:
 		signature.set(TypeIndex<_TComponent>());
 		m_entityManager->SetSignature(entity, signature);
 
-		m_systemManager->OnEntitySignatureChanged(entity, signature, this);
-		m_viewManager->OnEntitySignatureChanged(entity, signature);
+		NotifySignatureChanged(entity);
+	}
+
+	// Systems and views only see the components that are enabled
+	void NotifySignatureChanged(Entity entity)
+	{
+		Signature const& signature = m_entityManager->GetSignature(entity);
+		const Signature disabled = m_entityManager->GetDisabledSignature(entity);
+
+		m_systemManager->OnEntitySignatureChanged(entity, signature, disabled, this);
+		m_viewManager->OnEntitySignatureChanged(entity, signature, disabled);
 	}
 
 private:
+	struct SaveSnapshot
+	{
+		EntityManager Entities;
+		ComponentManager Components;
+	};
+
 	std::unique_ptr<ComponentManager> m_componentManager;
 	std::unique_ptr<EntityManager> m_entityManager;
 	std::unique_ptr<SystemManager> m_systemManager;
 	std::unique_ptr<ViewManager> m_viewManager;
+	std::unique_ptr<ResourceManager> m_resourceManager;
+	std::unique_ptr<FrameHistory<Scene>> m_history;
 
 	std::vector<Entity> m_entitiesToDestroy;
+
+	std::shared_ptr<SaveSnapshot> m_saveSnapshot;
+	// Unfinished saves, joined when the scene is destroyed instead of when their handle is dropped
+	std::vector<SaveTask> m_pendingSaves;
+
+	std::mutex m_batchMutex;
+	std::vector<EntityBatch> m_queuedBatches;
+
+	std::mutex m_deferredMutex;
+	std::vector<std::function<void(Scene&)>> m_deferred;
 };
 
 } // namespace Engine::ecs
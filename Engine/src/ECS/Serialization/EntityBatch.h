@@ -0,0 +1,40 @@
+#pragma once
+
+#include <functional>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <span>
+
+#include "../ComponentManager/ComponentManager.h"
+#include "../Entity/Entity.h"
+#include "../EntityManager/EntityManager.h"
+#include "SceneFile.h"
+
+namespace Engine::ecs
+{
+
+// Entities outside of a scene with their serializable components, see Scene::CopyToBatch and
+// Scene::QueueBatch. Handles are local to the batch and change when it is inserted, components
+// that store handles of other entities are copied as they are.
+struct EntityBatch
+{
+	std::unique_ptr<EntityManager> Entities = std::make_unique<EntityManager>();
+	std::unique_ptr<ComponentManager> Components = std::make_unique<ComponentManager>();
+
+	// Called by ConfirmChanges once the entities are in the scene, with their new handles
+	std::function<void(std::span<Entity const>)> OnInserted;
+
+	bool Write(std::ostream& stream) const
+	{
+		return details::WriteSceneFile(stream, *Entities, *Components);
+	}
+
+	// Expects an empty batch from Scene::CreateBatch, pools it doesn't have are skipped
+	bool Read(std::istream& stream)
+	{
+		return details::ReadSceneFile(stream, *Entities, *Components);
+	}
+};
+
+} // namespace Engine::ecs
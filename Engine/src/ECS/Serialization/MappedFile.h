@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <ios>
+#include <memory>
+#include <streambuf>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Engine::ecs::details
+{
+
+// Whole file mapped copy-on-write: pages stay shared with every other process mapping the
+// same file until this one writes to them, and writes never reach the file
+class MappedFile final
+{
+public:
+	static std::shared_ptr<MappedFile> Open(std::filesystem::path const& path)
+	{
+		auto file = std::shared_ptr<MappedFile>(new MappedFile());
+
+#ifdef _WIN32
+		file->m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file->m_file == INVALID_HANDLE_VALUE)
+		{
+			return nullptr;
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file->m_file, &size) || size.QuadPart == 0)
+		{
+			return nullptr;
+		}
+
+		file->m_mapping = CreateFileMappingW(file->m_file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (file->m_mapping == nullptr)
+		{
+			return nullptr;
+		}
+
+		file->m_data = static_cast<std::byte*>(MapViewOfFile(file->m_mapping, FILE_MAP_COPY, 0, 0, 0));
+		file->m_size = static_cast<std::size_t>(size.QuadPart);
+#else
+		const int descriptor = open(path.c_str(), O_RDONLY);
+		if (descriptor < 0)
+		{
+			return nullptr;
+		}
+
+		struct stat status;
+		if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+		{
+			close(descriptor);
+			return nullptr;
+		}
+
+		void* data = mmap(nullptr, static_cast<std::size_t>(status.st_size),
+			PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+		close(descriptor);
+
+		if (data != MAP_FAILED)
+		{
+			file->m_data = static_cast<std::byte*>(data);
+			file->m_size = static_cast<std::size_t>(status.st_size);
+		}
+#endif
+
+		return file->m_data ? file : nullptr;
+	}
+
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if (m_data)
+		{
+			UnmapViewOfFile(m_data);
+		}
+		if (m_mapping)
+		{
+			CloseHandle(m_mapping);
+		}
+		if (m_file != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_file);
+		}
+#else
+		if (m_data)
+		{
+			munmap(m_data, m_size);
+		}
+#endif
+	}
+
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+
+	std::byte* Data() const
+	{
+		return m_data;
+	}
+
+	std::size_t Size() const
+	{
+		return m_size;
+	}
+
+private:
+	MappedFile() = default;
+
+	std::byte* m_data = nullptr;
+	std::size_t m_size = 0;
+
+#ifdef _WIN32
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#endif
+};
+
+// Seekable input buffer over memory, lets the regular stream loader walk a mapped file
+class MemoryStreamBuffer final : public std::streambuf
+{
+public:
+	MemoryStreamBuffer(std::byte* data, std::size_t size)
+	{
+		char* begin = reinterpret_cast<char*>(data);
+		setg(begin, begin, begin + size);
+	}
+
+protected:
+	pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override
+	{
+		if (!(which & std::ios_base::in))
+		{
+			return pos_type(off_type(-1));
+		}
+
+		char* origin = direction == std::ios_base::beg ? eback()
+			: direction == std::ios_base::cur          ? gptr()
+													   : egptr();
+
+		if (offset < eback() - origin || offset > egptr() - origin)
+		{
+			return pos_type(off_type(-1));
+		}
+
+		setg(eback(), origin + offset, egptr());
+		return pos_type(gptr() - eback());
+	}
+
+	pos_type seekpos(pos_type position, std::ios_base::openmode which) override
+	{
+		return seekoff(off_type(position), std::ios_base::beg, which);
+	}
+};
+
+} // namespace Engine::ecs::details
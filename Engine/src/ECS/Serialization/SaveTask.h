@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace Engine::ecs
+{
+
+// Handle of a save running on its own thread, returned by Scene::SaveAsync. Copies share the save.
+// The scene keeps unfinished saves alive, dropping the handle doesn't wait for the file; destroying
+// the scene or the last handle of a save that outlived its scene does.
+class [[nodiscard]] SaveTask final
+{
+public:
+	using Duration = std::chrono::steady_clock::duration;
+
+	SaveTask() = default;
+
+	// snapshotPause is the time the caller spent taking the snapshot job works on
+	SaveTask(Duration snapshotPause, std::function<bool()> job)
+		: m_state(std::make_shared<State>())
+	{
+		m_state->MaxPause = snapshotPause;
+		m_state->Worker = std::jthread([state = m_state.get(), job = std::move(job)]() {
+			state->Result = job();
+			state->Done.store(true, std::memory_order_release);
+			state->Done.notify_all();
+		});
+	}
+
+	bool IsValid() const
+	{
+		return m_state != nullptr;
+	}
+
+	bool IsDone() const
+	{
+		return !m_state || m_state->Done.load(std::memory_order_acquire);
+	}
+
+	// Blocks until the file is written, time spent waiting counts as a pause
+	bool Wait()
+	{
+		if (!m_state)
+		{
+			return false;
+		}
+
+		if (!IsDone())
+		{
+			const auto start = std::chrono::steady_clock::now();
+			m_state->Done.wait(false, std::memory_order_acquire);
+			m_state->MaxPause = std::max<Duration>(m_state->MaxPause, std::chrono::steady_clock::now() - start);
+		}
+
+		return m_state->Result;
+	}
+
+	// Only meaningful once IsDone
+	bool Succeeded() const
+	{
+		return IsDone() && m_state && m_state->Result;
+	}
+
+	// Longest time the calling thread was stalled by this save: the snapshot or a blocking Wait
+	Duration GetMaxPause() const
+	{
+		return m_state ? m_state->MaxPause : Duration::zero();
+	}
+
+private:
+	struct State
+	{
+		std::atomic<bool> Done = false;
+		bool Result = false;
+		Duration MaxPause = Duration::zero();
+
+		// Declared last so the thread is joined before the rest of the state is destroyed.
+		// Only the last handle joins it, the worker itself holds no reference.
+		std::jthread Worker;
+	};
+
+	std::shared_ptr<State> m_state;
+};
+
+} // namespace Engine::ecs
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <ostream>
+
+#include "../ComponentManager/ComponentManager.h"
+#include "../EntityManager/EntityManager.h"
+#include "MappedFile.h"
+#include "Serialization.h"
+
+namespace Engine::ecs::details
+{
+
+// Magic, version and handle width, then the entity manager and every serializable pool
+inline bool WriteSceneFile(std::ostream& stream, EntityManager const& entityManager, ComponentManager const& componentManager)
+{
+	WriteBytes(stream, SceneFormatMagic, sizeof(SceneFormatMagic));
+	WriteValue(stream, SceneFormatVersion);
+	WriteValue(stream, static_cast<std::uint32_t>(sizeof(EntityIdType)));
+
+	entityManager.Serialize(stream);
+	componentManager.Serialize(stream, entityManager);
+
+	return !stream.fail();
+}
+
+// Fills an empty entity manager and the registered pools of componentManager.
+// Component masks are left to the caller.
+inline bool ReadSceneFile(std::istream& stream,
+	EntityManager& entityManager,
+	ComponentManager& componentManager,
+	std::shared_ptr<MappedFile> const& mapping = nullptr)
+{
+	char magic[sizeof(SceneFormatMagic)];
+	std::uint32_t version = 0;
+	std::uint32_t entitySize = 0;
+
+	if (!ReadBytes(stream, magic, sizeof(magic))
+		|| !std::equal(std::begin(magic), std::end(magic), std::begin(SceneFormatMagic))
+		|| !ReadValue(stream, version) || version != SceneFormatVersion
+		|| !ReadValue(stream, entitySize) || entitySize != sizeof(EntityIdType))
+	{
+		return false;
+	}
+
+	return entityManager.Deserialize(stream) && componentManager.Deserialize(stream, entityManager, mapping);
+}
+
+} // namespace Engine::ecs::details
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <ranges>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "../TypeIndex/TypeIndex.h"
+
+namespace Engine::ecs
+{
+
+// Specialize for components that are not trivially copyable, or to override the raw byte copy:
+//   static void Write(std::ostream& stream, T const& value);
+//   static T Read(std::istream& stream);
+template <typename _TComponent>
+struct ComponentSerializer
+{
+};
+
+constexpr std::uint32_t SceneFormatVersion = 2;
+
+} // namespace Engine::ecs
+
+namespace Engine::ecs::details
+{
+
+constexpr char SceneFormatMagic[4] = { 'E', 'C', 'S', 'B' };
+
+// Raw blocks start at a multiple of this stream offset so a mapped file can be used in place
+constexpr std::size_t BlockAlignment = 64;
+
+template <typename _T>
+concept HasSerializer = requires(std::ostream& out, std::istream& in, _T const& value) {
+	ComponentSerializer<_T>::Write(out, value);
+	{ ComponentSerializer<_T>::Read(in) } -> std::convertible_to<_T>;
+};
+
+template <typename _T>
+concept Serializable = HasSerializer<_T> || std::is_trivially_copyable_v<_T>;
+
+// FNV-1a of the compiler's type name, files are portable between builds of the same toolchain
+template <typename _T>
+std::uint64_t TypeKey()
+{
+	std::uint64_t hash = 14695981039346656037ull;
+	for (char c : std::string_view(Name<_T>()))
+	{
+		hash ^= static_cast<std::uint8_t>(c);
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+inline void WriteBytes(std::ostream& stream, void const* data, std::size_t size)
+{
+	stream.write(static_cast<char const*>(data), static_cast<std::streamsize>(size));
+}
+
+inline bool ReadBytes(std::istream& stream, void* data, std::size_t size)
+{
+	stream.read(static_cast<char*>(data), static_cast<std::streamsize>(size));
+	return !stream.fail();
+}
+
+inline void WritePadding(std::ostream& stream)
+{
+	static constexpr char zeros[BlockAlignment] = {};
+
+	const auto position = static_cast<std::size_t>(stream.tellp());
+	WriteBytes(stream, zeros, (BlockAlignment - position % BlockAlignment) % BlockAlignment);
+}
+
+inline bool SkipPadding(std::istream& stream)
+{
+	const auto position = static_cast<std::size_t>(stream.tellg());
+	stream.seekg(static_cast<std::streamoff>((BlockAlignment - position % BlockAlignment) % BlockAlignment), std::ios::cur);
+	return !stream.fail();
+}
+
+// Bytes left between the read position and the end of the stream, bounds counts read from a file
+inline std::uint64_t RemainingBytes(std::istream& stream)
+{
+	const auto position = stream.tellg();
+	stream.seekg(0, std::ios::end);
+	const auto end = stream.tellg();
+	stream.seekg(position);
+
+	return !stream.fail() && end > position ? static_cast<std::uint64_t>(end - position) : 0;
+}
+
+template <typename _T>
+void WriteValue(std::ostream& stream, _T const& value)
+{
+	static_assert(std::is_trivially_copyable_v<_T>);
+	WriteBytes(stream, &value, sizeof(_T));
+}
+
+template <typename _T>
+bool ReadValue(std::istream& stream, _T& value)
+{
+	static_assert(std::is_trivially_copyable_v<_T>);
+	return ReadBytes(stream, &value, sizeof(_T));
+}
+
+// Element count followed by the elements, one aligned block for trivially copyable types
+template <std::ranges::contiguous_range _TRange>
+	requires Serializable<std::ranges::range_value_t<_TRange>>
+void WriteArray(std::ostream& stream, _TRange const& values)
+{
+	using Value = std::ranges::range_value_t<_TRange>;
+
+	WriteValue(stream, static_cast<std::uint64_t>(std::ranges::size(values)));
+
+	if constexpr (HasSerializer<Value>)
+	{
+		for (Value const& value : values)
+		{
+			ComponentSerializer<Value>::Write(stream, value);
+		}
+	}
+	else
+	{
+		static_assert(alignof(Value) <= BlockAlignment);
+
+		WritePadding(stream);
+		WriteBytes(stream, std::ranges::data(values), std::ranges::size(values) * sizeof(Value));
+	}
+}
+
+template <Serializable _T>
+bool ReadArray(std::istream& stream, std::vector<_T>& values)
+{
+	std::uint64_t count = 0;
+	if (!ReadValue(stream, count))
+	{
+		return false;
+	}
+
+	values.clear();
+
+	const std::uint64_t remaining = RemainingBytes(stream);
+
+	if constexpr (HasSerializer<_T>)
+	{
+		values.reserve(static_cast<std::size_t>(std::min(count, remaining)));
+		for (std::uint64_t i = 0; i < count && stream; ++i)
+		{
+			values.push_back(ComponentSerializer<_T>::Read(stream));
+		}
+
+		return !stream.fail();
+	}
+	else
+	{
+		if (count > remaining / sizeof(_T))
+		{
+			return false;
+		}
+
+		values.resize(count);
+		return SkipPadding(stream) && ReadBytes(stream, values.data(), values.size() * sizeof(_T));
+	}
+}
+
+} // namespace Engine::ecs::details
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "../Serialization/Serialization.h"
+
+namespace Engine::ecs
+{
+
+using SharedHandle = std::uint32_t;
+
+// Component mode for values many entities have in common (render materials, physics materials).
+// Identical values are interned once per type, each entity only stores the handle.
+template <typename _TValue>
+struct Shared
+{
+	SharedHandle Handle = std::numeric_limits<SharedHandle>::max();
+};
+
+} // namespace Engine::ecs
+
+namespace Engine::ecs::details
+{
+
+template <typename _T>
+struct SharedTraits
+{
+	static constexpr bool IsShared = false;
+	using ValueType = _T;
+};
+
+template <typename _TValue>
+struct SharedTraits<Shared<_TValue>>
+{
+	static constexpr bool IsShared = true;
+	using ValueType = _TValue;
+};
+
+template <typename _T>
+constexpr bool IsShared = SharedTraits<_T>::IsShared;
+
+template <typename _T>
+concept Hashable = requires(_T const& value) {
+	{ std::hash<_T>{}(value) } -> std::convertible_to<std::size_t>;
+};
+
+template <typename _TValue>
+class SharedTable final
+{
+public:
+	// Finds or inserts the value, the handle is not referenced until a component holds it
+	SharedHandle Intern(_TValue const& value)
+	{
+		if constexpr (Hashable<_TValue>)
+		{
+			if (auto it = m_lookup.find(value); it != m_lookup.end())
+			{
+				return it->second;
+			}
+		}
+		else
+		{
+			for (SharedHandle handle = 0; handle < m_values.size(); ++handle)
+			{
+				if (m_refCounts[handle] != FreeSlot && m_values[handle] == value)
+				{
+					return handle;
+				}
+			}
+		}
+
+		SharedHandle handle;
+		if (!m_freeHandles.empty())
+		{
+			handle = m_freeHandles.back();
+			m_freeHandles.pop_back();
+			m_values[handle] = value;
+			m_refCounts[handle] = 0;
+		}
+		else
+		{
+			handle = static_cast<SharedHandle>(m_values.size());
+			m_values.push_back(value);
+			m_refCounts.push_back(0);
+		}
+
+		if constexpr (Hashable<_TValue>)
+		{
+			m_lookup.emplace(value, handle);
+		}
+
+		return handle;
+	}
+
+	void AddRef(SharedHandle handle)
+	{
+		assert(IsLive(handle) && "Shared handle is not interned");
+		m_refCounts[handle]++;
+	}
+
+	void Release(SharedHandle handle)
+	{
+		assert(IsLive(handle) && m_refCounts[handle] > 0 && "Shared handle is not referenced");
+
+		if (--m_refCounts[handle] == 0)
+		{
+			if constexpr (Hashable<_TValue>)
+			{
+				m_lookup.erase(m_values[handle]);
+			}
+
+			m_refCounts[handle] = FreeSlot;
+			m_freeHandles.push_back(handle);
+		}
+	}
+
+	_TValue const& Get(SharedHandle handle) const
+	{
+		assert(IsLive(handle) && "Shared handle is not interned");
+		return m_values[handle];
+	}
+
+	// Upper bound for handles, live or free
+	std::size_t Capacity() const
+	{
+		return m_values.size();
+	}
+
+	void Serialize(std::ostream& stream) const
+		requires Serializable<_TValue>
+	{
+		WriteArray(stream, m_values);
+		WriteArray(stream, m_refCounts);
+		WriteArray(stream, m_freeHandles);
+	}
+
+	bool Deserialize(std::istream& stream)
+		requires Serializable<_TValue>
+	{
+		if (!ReadArray(stream, m_values) || !ReadArray(stream, m_refCounts) || !ReadArray(stream, m_freeHandles)
+			|| m_values.size() != m_refCounts.size())
+		{
+			return false;
+		}
+
+		if constexpr (Hashable<_TValue>)
+		{
+			m_lookup.clear();
+			for (SharedHandle handle = 0; handle < m_values.size(); ++handle)
+			{
+				if (m_refCounts[handle] != FreeSlot)
+				{
+					m_lookup.emplace(m_values[handle], handle);
+				}
+			}
+		}
+
+		return true;
+	}
+
+private:
+	static constexpr std::uint32_t FreeSlot = std::numeric_limits<std::uint32_t>::max();
+
+	struct NoLookup
+	{
+	};
+
+	bool IsLive(SharedHandle handle) const
+	{
+		return handle < m_values.size() && m_refCounts[handle] != FreeSlot;
+	}
+
+	std::vector<_TValue> m_values;
+	std::vector<std::uint32_t> m_refCounts;
+	std::vector<SharedHandle> m_freeHandles;
+	std::conditional_t<Hashable<_TValue>, std::unordered_map<_TValue, SharedHandle>, NoLookup> m_lookup;
+};
+
+struct NoSharedTable
+{
+};
+
+template <typename _TComponent>
+using SharedTableFor = std::conditional_t<IsShared<_TComponent>,
+	SharedTable<typename SharedTraits<_TComponent>::ValueType>,
+	NoSharedTable>;
+
+} // namespace Engine::ecs::details
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Engine::ecs::details
+{
+
+// Stream: magic, version, then one record per frame.
+// Record: RecordHeader, LZ4 block of the frame XOR-ed with the previous frame unless it is a keyframe.
+// Frame: FrameHeader, then per pool a PoolHeader, its entities and its components, each padded to SnapshotAlignment.
+constexpr char SnapshotMagic[4] = { 'E', 'C', 'S', 'R' };
+constexpr std::uint32_t SnapshotVersion = 1;
+constexpr std::size_t SnapshotAlignment = 16;
+
+struct SnapshotRecordHeader
+{
+	std::uint32_t RawSize;
+	std::uint32_t CompressedSize;
+	std::uint32_t Keyframe;
+	std::uint32_t Reserved;
+};
+
+struct SnapshotFrameHeader
+{
+	std::uint64_t FrameIndex;
+	std::uint32_t PoolCount;
+	std::uint32_t Reserved;
+};
+
+struct SnapshotPoolHeader
+{
+	std::uint64_t TypeKey;
+	std::uint64_t Count;
+	std::uint32_t ComponentSize;
+	std::uint32_t Reserved;
+};
+
+constexpr std::size_t AlignSnapshotSize(std::size_t size)
+{
+	return (size + SnapshotAlignment - 1) / SnapshotAlignment * SnapshotAlignment;
+}
+
+} // namespace Engine::ecs::details
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "common/tracy_lz4.hpp"
+
+#include "../Entity/Entity.h"
+#include "../Serialization/Serialization.h"
+#include "SnapshotFormat.h"
+
+namespace Engine::ecs
+{
+
+// Plays back a stream written by SnapshotWriter one frame at a time
+class SnapshotReader final
+{
+public:
+	explicit SnapshotReader(std::filesystem::path const& path)
+		: m_file(path, std::ios::binary)
+	{
+		char magic[sizeof(details::SnapshotMagic)] = {};
+		std::uint32_t version = 0;
+
+		m_open = details::ReadBytes(m_file, magic, sizeof(magic))
+			&& std::memcmp(magic, details::SnapshotMagic, sizeof(magic)) == 0
+			&& details::ReadValue(m_file, version)
+			&& version == details::SnapshotVersion;
+	}
+
+	bool IsOpen() const
+	{
+		return m_open;
+	}
+
+	// Decodes the next frame, returns false at the end of the stream or on a corrupt record
+	bool Next()
+	{
+		details::SnapshotRecordHeader header;
+		if (!m_open || !details::ReadValue(m_file, header))
+		{
+			return false;
+		}
+
+		m_compressed.resize(header.CompressedSize);
+		if (!details::ReadBytes(m_file, m_compressed.data(), m_compressed.size()))
+		{
+			return false;
+		}
+
+		// A delta can only be applied on top of the frame it was made against
+		if (!header.Keyframe && !m_hasFrame)
+		{
+			return false;
+		}
+
+		m_delta.resize(header.RawSize);
+		const int decoded = tracy::LZ4_decompress_safe(
+			reinterpret_cast<char const*>(m_compressed.data()),
+			reinterpret_cast<char*>(m_delta.data()),
+			static_cast<int>(header.CompressedSize),
+			static_cast<int>(header.RawSize));
+
+		if (decoded != static_cast<int>(header.RawSize) || header.RawSize < sizeof(details::SnapshotFrameHeader))
+		{
+			m_hasFrame = false;
+			return false;
+		}
+
+		if (!header.Keyframe)
+		{
+			const std::size_t common = std::min(m_delta.size(), m_frame.size());
+			for (std::size_t i = 0; i < common; ++i)
+			{
+				m_delta[i] ^= m_frame[i];
+			}
+		}
+
+		std::swap(m_frame, m_delta);
+		m_hasFrame = true;
+
+		return Index();
+	}
+
+	std::uint64_t GetFrameIndex() const
+	{
+		return m_frameIndex;
+	}
+
+	template <typename _TComponent>
+	bool HasComponents() const
+	{
+		return Find(details::TypeKey<_TComponent>()) != nullptr;
+	}
+
+	// Views into the decoded frame, valid until the next call to Next
+	template <typename _TComponent>
+	std::span<_TComponent const> GetComponents() const
+	{
+		static_assert(std::is_trivially_copyable_v<_TComponent>);
+
+		Pool const* pool = Find(details::TypeKey<_TComponent>());
+		if (!pool || pool->ComponentSize != sizeof(_TComponent))
+		{
+			return {};
+		}
+
+		return { reinterpret_cast<_TComponent const*>(m_frame.data() + pool->ComponentOffset), pool->Count };
+	}
+
+	template <typename _TComponent>
+	std::span<Entity const> GetEntities() const
+	{
+		Pool const* pool = Find(details::TypeKey<_TComponent>());
+		if (!pool)
+		{
+			return {};
+		}
+
+		return { reinterpret_cast<Entity const*>(m_frame.data() + pool->EntityOffset), pool->Count };
+	}
+
+private:
+	struct Pool
+	{
+		std::uint64_t TypeKey;
+		std::size_t Count;
+		std::size_t ComponentSize;
+		std::size_t EntityOffset;
+		std::size_t ComponentOffset;
+	};
+
+	// Locates the pools of the decoded frame, including those of types this build doesn't know
+	bool Index()
+	{
+		m_pools.clear();
+
+		details::SnapshotFrameHeader frameHeader;
+		std::memcpy(&frameHeader, m_frame.data(), sizeof(frameHeader));
+		m_frameIndex = frameHeader.FrameIndex;
+
+		std::size_t offset = details::AlignSnapshotSize(sizeof(frameHeader));
+		for (std::uint32_t i = 0; i < frameHeader.PoolCount; ++i)
+		{
+			details::SnapshotPoolHeader poolHeader;
+			if (offset + sizeof(poolHeader) > m_frame.size())
+			{
+				return false;
+			}
+			std::memcpy(&poolHeader, m_frame.data() + offset, sizeof(poolHeader));
+			offset += details::AlignSnapshotSize(sizeof(poolHeader));
+
+			Pool pool{ poolHeader.TypeKey, static_cast<std::size_t>(poolHeader.Count), poolHeader.ComponentSize, offset, 0 };
+			offset += details::AlignSnapshotSize(pool.Count * sizeof(Entity));
+			pool.ComponentOffset = offset;
+			offset += details::AlignSnapshotSize(pool.Count * pool.ComponentSize);
+
+			if (offset > m_frame.size())
+			{
+				return false;
+			}
+
+			m_pools.push_back(pool);
+		}
+
+		return true;
+	}
+
+	Pool const* Find(std::uint64_t typeKey) const
+	{
+		for (Pool const& pool : m_pools)
+		{
+			if (pool.TypeKey == typeKey)
+			{
+				return &pool;
+			}
+		}
+
+		return nullptr;
+	}
+
+	std::ifstream m_file;
+	bool m_open = false;
+	bool m_hasFrame = false;
+
+	std::uint64_t m_frameIndex = 0;
+	std::vector<Pool> m_pools;
+
+	std::vector<std::byte> m_frame;
+	std::vector<std::byte> m_delta;
+	std::vector<std::byte> m_compressed;
+};
+
+} // namespace Engine::ecs
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "common/tracy_lz4.hpp"
+
+#include "../Scene/Scene.h"
+#include "../Serialization/Serialization.h"
+#include "../Shared/Shared.h"
+#include "SnapshotFormat.h"
+
+namespace Engine::ecs
+{
+
+// Streams the tracked pools of every captured frame to a file for replays and determinism checks.
+// Capture only copies the pools; delta encoding, LZ4 compression and writing run on a background
+// thread. LZ4 comes from the vendored tracy_lz4.cpp, which TracyClient.cpp compiles in.
+class SnapshotWriter final
+{
+public:
+	// A keyframe is stored without delta every keyframeInterval frames so a reader can start there.
+	// Frames captured while maxQueuedFrames are still waiting for the worker are dropped.
+	explicit SnapshotWriter(std::filesystem::path const& path, size_t keyframeInterval = 60, size_t maxQueuedFrames = 8)
+		: m_file(path, std::ios::binary | std::ios::trunc)
+		, m_keyframeInterval(std::max<size_t>(keyframeInterval, 1))
+		, m_maxQueuedFrames(std::max<size_t>(maxQueuedFrames, 1))
+	{
+		details::WriteBytes(m_file, details::SnapshotMagic, sizeof(details::SnapshotMagic));
+		details::WriteValue(m_file, details::SnapshotVersion);
+
+		m_worker = std::jthread([this](std::stop_token stopToken) {
+			WorkerLoop(stopToken);
+		});
+	}
+
+	// Waits for queued frames to be written
+	~SnapshotWriter()
+	{
+		m_worker.request_stop();
+		m_worker.join();
+	}
+
+	SnapshotWriter(SnapshotWriter const&) = delete;
+	SnapshotWriter& operator=(SnapshotWriter const&) = delete;
+
+	bool IsOpen() const
+	{
+		return m_file.is_open();
+	}
+
+	template <typename _TComponent>
+	SnapshotWriter& Track()
+	{
+		static_assert(!details::IsShared<_TComponent>, "Shared components can't be snapshotted");
+		static_assert(std::is_trivially_copyable_v<_TComponent>, "Snapshots copy components as raw bytes");
+		static_assert(alignof(_TComponent) <= details::SnapshotAlignment);
+
+		m_pools.push_back([](Scene& scene, std::vector<std::byte>& frame) {
+			auto components = scene.GetComponents<_TComponent>();
+			auto entities = scene.GetComponentEntities<_TComponent>();
+
+			const details::SnapshotPoolHeader header{
+				details::TypeKey<_TComponent>(), components.size(), static_cast<std::uint32_t>(sizeof(_TComponent)), 0
+			};
+			Append(frame, &header, sizeof(header));
+			Append(frame, entities.data(), entities.size_bytes());
+			Append(frame, components.data(), components.size_bytes());
+		});
+
+		return *this;
+	}
+
+	// Call between frames, after ConfirmChanges. Returns false if the frame was dropped.
+	bool Capture(Scene& scene)
+	{
+		const std::uint64_t frameIndex = m_frameIndex++;
+
+		std::vector<std::byte> frame;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (m_queue.size() >= m_maxQueuedFrames)
+			{
+				m_droppedFrames++;
+				return false;
+			}
+
+			if (!m_spareBuffers.empty())
+			{
+				frame = std::move(m_spareBuffers.back());
+				m_spareBuffers.pop_back();
+			}
+		}
+
+		frame.clear();
+
+		const details::SnapshotFrameHeader header{ frameIndex, static_cast<std::uint32_t>(m_pools.size()), 0 };
+		Append(frame, &header, sizeof(header));
+
+		for (auto const& pool : m_pools)
+		{
+			pool(scene, frame);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_queue.push_back(std::move(frame));
+		}
+		m_condition.notify_one();
+
+		return true;
+	}
+
+	size_t GetWrittenFrames() const
+	{
+		return m_writtenFrames;
+	}
+
+	size_t GetDroppedFrames() const
+	{
+		return m_droppedFrames;
+	}
+
+private:
+	static void Append(std::vector<std::byte>& frame, void const* data, size_t size)
+	{
+		const size_t offset = frame.size();
+		frame.resize(offset + details::AlignSnapshotSize(size));
+
+		if (size > 0)
+		{
+			std::memcpy(frame.data() + offset, data, size);
+		}
+	}
+
+	void WorkerLoop(std::stop_token stopToken)
+	{
+		while (true)
+		{
+			std::vector<std::byte> frame;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, stopToken, [this]() {
+					return !m_queue.empty();
+				});
+
+				if (m_queue.empty())
+				{
+					return;
+				}
+
+				frame = std::move(m_queue.front());
+				m_queue.pop_front();
+			}
+
+			Write(frame);
+
+			// The raw frame becomes the reference for the next delta
+			std::swap(frame, m_previous);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_spareBuffers.push_back(std::move(frame));
+		}
+	}
+
+	void Write(std::vector<std::byte> const& frame)
+	{
+		assert(frame.size() <= static_cast<size_t>(std::numeric_limits<int>::max()) && "Snapshot frame is too large for one LZ4 block");
+
+		const bool keyframe = m_writtenFrames % m_keyframeInterval == 0;
+
+		m_delta.resize(frame.size());
+		const size_t common = keyframe ? 0 : std::min(frame.size(), m_previous.size());
+		for (size_t i = 0; i < common; ++i)
+		{
+			m_delta[i] = frame[i] ^ m_previous[i];
+		}
+		std::memcpy(m_delta.data() + common, frame.data() + common, frame.size() - common);
+
+		const int rawSize = static_cast<int>(m_delta.size());
+		m_compressed.resize(static_cast<size_t>(tracy::LZ4_compressBound(rawSize)));
+
+		const int compressedSize = tracy::LZ4_compress_default(
+			reinterpret_cast<char const*>(m_delta.data()),
+			reinterpret_cast<char*>(m_compressed.data()),
+			rawSize,
+			static_cast<int>(m_compressed.size()));
+
+		const details::SnapshotRecordHeader header{
+			static_cast<std::uint32_t>(rawSize),
+			static_cast<std::uint32_t>(compressedSize),
+			keyframe ? 1u : 0u,
+			0
+		};
+
+		details::WriteValue(m_file, header);
+		details::WriteBytes(m_file, m_compressed.data(), static_cast<size_t>(compressedSize));
+		m_file.flush();
+
+		m_writtenFrames++;
+	}
+
+	std::ofstream m_file;
+	size_t m_keyframeInterval;
+	size_t m_maxQueuedFrames;
+
+	std::vector<std::function<void(Scene&, std::vector<std::byte>&)>> m_pools;
+	std::uint64_t m_frameIndex = 0;
+
+	std::mutex m_mutex;
+	std::condition_variable_any m_condition;
+	std::deque<std::vector<std::byte>> m_queue;
+	std::vector<std::vector<std::byte>> m_spareBuffers;
+
+	std::atomic<size_t> m_writtenFrames = 0;
+	std::atomic<size_t> m_droppedFrames = 0;
+
+	// Owned by the worker
+	std::vector<std::byte> m_previous;
+	std::vector<std::byte> m_delta;
+	std::vector<std::byte> m_compressed;
+
+	// Declared last so the worker stops before the members it uses are destroyed
+	std::jthread m_worker;
+};
+
+} // namespace Engine::ecs
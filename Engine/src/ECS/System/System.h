@@ -1,8 +1,11 @@
 #pragma once
 
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "../EntityWrapper/EntityWrapper.h"
+#include "../TypeIndex/TypeIndex.h"
 
 namespace Engine::ecs
 {
@@ -18,6 +21,29 @@ public:
 
 	virtual void Update(Scene& scene, float dt) = 0;
 
+	// Copy with the state kept between frames, for a clone of the scene. Systems that return
+	// nullptr are recreated from their registration arguments and start from scratch.
+	// Entities and EntityToIndexMap are filled in by the caller.
+	virtual std::unique_ptr<System> Clone() const
+	{
+		return nullptr;
+	}
+
+	// OnEntityAdded runs once the entity is in Entities, OnEntityRemoved just before it leaves them
+	virtual void OnEntityAdded(Entity entity)
+	{
+	}
+
+	virtual void OnEntityRemoved(Entity entity)
+	{
+	}
+
+	// Called from Scene::MarkChanged when componentType is in the signature. The entity may be one
+	// the system doesn't hold, looking it up in EntityToIndexMap is left to systems that care.
+	virtual void OnComponentChanged(Entity entity, TypeIndexType componentType)
+	{
+	}
+
 	std::vector<WrappedEntity> Entities;
 	std::unordered_map<Entity, size_t> EntityToIndexMap;
 };
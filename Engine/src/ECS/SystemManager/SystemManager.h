@@ -1,17 +1,24 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <mutex>
 #include <queue>
-#include <thread>
+#include <span>
 #include <unordered_map>
 #include <vector>
 
 #include "../ComponentManager/ComponentManager.h"
 #include "../EntityManager/EntityManager.h"
+#include "../ResourceManager/ResourceManager.h"
 #include "../System/System.h"
 #include "../TypeIndex/TypeIndex.h"
+#include "WorkerPool.h"
 
 namespace Engine::ecs
 {
@@ -45,6 +52,22 @@ public:
 			return *this;
 		}
 
+		template <typename... _TResources>
+		SystemConfiguration& WithResourceRead()
+		{
+			m_manager.AddResourceDependencies<_TResources...>(m_manager.m_resourceReads, m_id);
+
+			return *this;
+		}
+
+		template <typename... _TResources>
+		SystemConfiguration& WithResourceWrite()
+		{
+			m_manager.AddResourceDependencies<_TResources...>(m_manager.m_resourceWrites, m_id);
+
+			return *this;
+		}
+
 	private:
 		SystemId m_id;
 		SystemManager& m_manager;
@@ -52,7 +75,6 @@ public:
 
 public:
 	SystemManager();
-	~SystemManager();
 
 	template <typename _TSystem, typename... _TArgs>
 	SystemConfiguration RegisterSystem(_TArgs&&... args);
@@ -66,12 +88,27 @@ public:
 	template <typename _TSystem>
 	_TSystem const& GetSystem() const;
 
-	void OnEntitySignatureChanged(Entity entity, Signature entitySignature, Scene* scene);
+	// A system holds the entity while every component it needs is there and enabled
+	void OnEntitySignatureChanged(Entity entity, Signature entitySignature, Signature disabledSignature, Scene* scene);
+
+	// Forwards Scene::MarkChanged to the systems whose signature has the type
+	void OnComponentChanged(std::span<Entity const> entities, ComponentType componentType);
 
 	void BuildExecutionGraph();
 
 	void Execute(Scene& scene, float dt);
 
+	// Copies every system through System::Clone, or recreates it when it was registered with
+	// copyable constructor arguments, along with its dependencies and entity lists, for the given
+	// clone of the owning scene. Systems that allow neither (usually built from references into the
+	// source scene) are left out. The worker pool is shared.
+	std::unique_ptr<SystemManager> Clone(Scene* scene) const;
+
+	// Splits [0, count) into chunks of grainSize and runs func(begin, end) on the worker pool.
+	// The calling thread takes chunks as well, so systems may call it from inside Update.
+	template <typename _TFunc>
+	void ParallelFor(size_t count, size_t grainSize, _TFunc&& func);
+
 private:
 	template <typename... _TComponents>
 	void AddReadDependencies(SystemId systemId);
@@ -79,27 +116,32 @@ private:
 	template <typename _TComponent>
 	void AddWriteDependency(SystemId systemId);
 
-	void WorkerLoop();
+	template <typename... _TResources>
+	void AddResourceDependencies(std::unordered_map<SystemId, std::vector<ResourceId>>& dependencies, SystemId systemId);
+
+	explicit SystemManager(std::shared_ptr<details::WorkerPool> workerPool);
 
 private:
+	using SystemFactory = std::function<std::unique_ptr<System>()>;
+
 	SystemId m_currentSystemId = InvalidEntity;
 
 	std::unordered_map<SystemId, std::unique_ptr<System>> m_systems;
+	std::unordered_map<SystemId, SystemFactory> m_factories;
 	std::unordered_map<SystemId, Signature> m_signatures;
 	std::unordered_map<SystemId, Signature> m_readDependencies;
 	std::unordered_map<SystemId, ComponentType> m_writeDependencies;
+	std::unordered_map<SystemId, std::vector<ResourceId>> m_resourceReads;
+	std::unordered_map<SystemId, std::vector<ResourceId>> m_resourceWrites;
 
 	std::vector<std::vector<SystemId>> m_executionStages;
 
 	std::unordered_map<Entity, size_t> m_entityToIndexMap;
 
-	std::vector<std::jthread> m_workerThreads;
-	std::queue<std::function<void()>> m_taskQueue;
-	std::mutex m_queueMutex;
-	std::condition_variable m_workerCondition;
-	std::condition_variable m_mainCondition;
+	std::shared_ptr<details::WorkerPool> m_workerPool;
+	std::mutex m_stageMutex;
+	std::condition_variable m_stageCondition;
 	std::atomic<size_t> m_tasksInProgress = 0;
-	std::atomic<bool> m_stopThreads = false;
 };
 
 } // namespace Engine::ecs
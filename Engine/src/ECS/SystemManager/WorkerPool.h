@@ -0,0 +1,88 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Engine::ecs::details
+{
+
+// Threads that run submitted tasks in FIFO order, shared by a scene and its clones
+class WorkerPool final
+{
+public:
+	explicit WorkerPool(size_t threadCount = std::thread::hardware_concurrency())
+	{
+		m_threads.reserve(threadCount);
+		for (size_t i = 0; i < threadCount; ++i)
+		{
+			m_threads.emplace_back(&WorkerPool::WorkerLoop, this);
+		}
+	}
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			m_stopThreads = true;
+		}
+		m_workerCondition.notify_all();
+
+		m_threads.clear();
+	}
+
+	WorkerPool(WorkerPool const&) = delete;
+	WorkerPool& operator=(WorkerPool const&) = delete;
+
+	size_t GetThreadCount() const
+	{
+		return m_threads.size();
+	}
+
+	void Submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			m_taskQueue.push(std::move(task));
+		}
+		m_workerCondition.notify_one();
+	}
+
+private:
+	void WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(m_queueMutex);
+				m_workerCondition.wait(lock, [this]() {
+					return m_stopThreads || !m_taskQueue.empty();
+				});
+
+				if (m_stopThreads && m_taskQueue.empty())
+				{
+					return;
+				}
+
+				task = std::move(m_taskQueue.front());
+				m_taskQueue.pop();
+			}
+
+			task();
+		}
+	}
+
+	std::queue<std::function<void()>> m_taskQueue;
+	std::mutex m_queueMutex;
+	std::condition_variable m_workerCondition;
+	bool m_stopThreads = false;
+
+	// Declared last so the threads are joined before the queue they read is destroyed
+	std::vector<std::jthread> m_threads;
+};
+
+} // namespace Engine::ecs::details
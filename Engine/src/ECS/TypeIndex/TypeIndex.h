@@ -5,6 +5,8 @@
 namespace Engine::ecs::details
 {
 
+// Each family numbers its types densely from zero
+template <typename _TFamily>
 class TypeIndexGenerator final
 {
 public:
@@ -20,6 +22,9 @@ private:
 	inline static std::size_t m_counter = 0;
 };
 
+struct SignatureFamily;
+struct ResourceFamily;
+
 } // namespace Engine::ecs::details
 
 namespace Engine::ecs
@@ -30,7 +35,13 @@ using TypeIndexType = std::size_t;
 template <typename _T>
 TypeIndexType TypeIndex()
 {
-	return details::TypeIndexGenerator::Get<_T>();
+	return details::TypeIndexGenerator<details::SignatureFamily>::Get<_T>();
+}
+
+template <typename _T>
+TypeIndexType ResourceIndex()
+{
+	return details::TypeIndexGenerator<details::ResourceFamily>::Get<_T>();
 }
 
 template <typename _T>
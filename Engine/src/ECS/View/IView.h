@@ -10,8 +10,9 @@ class IView
 {
 public:
 	virtual ~IView() = default;
-	virtual void OnEntitySignatureChanged(Entity entity, Signature signature) = 0;
+	virtual void OnEntitySignatureChanged(Entity entity, Signature signature, Signature disabled) = 0;
 	virtual void OnEntityDestroyed(Entity entity) = 0;
+	virtual void OnComponentsReordered() = 0;
 };
 
 } // namespace Engine::ecs
@@ -1,10 +1,29 @@
 #pragma once
 
+#include <span>
 #include <tuple>
 #include <vector>
 
+#include "../../BitVector/BitVector.h"
 #include "../../ComponentManager/ComponentManager.h"
 
+namespace Engine::ecs::details
+{
+
+template <typename _TComponent, bool IsConst>
+struct ViewReference
+{
+	using Type = std::conditional_t<IsConst, _TComponent const&, _TComponent&>;
+};
+
+template <typename _TValue, bool IsConst>
+struct ViewReference<Shared<_TValue>, IsConst>
+{
+	using Type = _TValue const&;
+};
+
+} // namespace Engine::ecs::details
+
 namespace Engine::ecs
 {
 
@@ -12,25 +31,47 @@ template <bool IsConst, typename... _TComponents>
 class ViewIterator final
 {
 public:
-	using EntityIterator = std::conditional_t<IsConst,
-		typename std::vector<Entity>::const_iterator,
-		typename std::vector<Entity>::iterator>;
-
 	using iterator_category = std::forward_iterator_tag;
 	using difference_type = std::ptrdiff_t;
-	using value_type = std::conditional_t<IsConst,
-		std::tuple<Entity, const _TComponents&...>,
-		std::tuple<Entity, _TComponents&...>>;
+	using value_type = std::tuple<Entity, typename details::ViewReference<_TComponents, IsConst>::Type...>;
 
-	ViewIterator(ComponentManager& manager, EntityIterator it)
+	ViewIterator(ComponentManager& manager, std::vector<Entity> const& entities,
+		details::BitVector const& disabled, std::size_t position)
 		: m_manager(manager)
-		, m_it(it)
+		, m_entities(&entities)
+		, m_disabled(&disabled)
+		, m_position(position)
 	{
 	}
 
+	// Walks the leading range of a group, where component i of every pool belongs to entity i.
+	// Disabled bits are looked up through the view positions, positions is null when none is set.
+	ViewIterator(ComponentManager& manager, std::span<Entity const> group,
+		std::vector<details::EntityIdType> const* positions, details::BitVector const& disabled, std::size_t position)
+		: m_manager(manager)
+		, m_entities(nullptr)
+		, m_disabled(&disabled)
+		, m_position(position)
+		, m_group(group.data())
+		, m_groupSize(group.size())
+		, m_components(manager.GetComponents<_TComponents>().data()...)
+		, m_positions(positions)
+	{
+		SkipDisabled();
+	}
+
 	ViewIterator& operator++()
 	{
-		++m_it;
+		if (m_group)
+		{
+			++m_position;
+			SkipDisabled();
+		}
+		else
+		{
+			m_position = m_disabled->NextUnset(m_position + 1);
+		}
+
 		return *this;
 	}
 
@@ -43,24 +84,73 @@ public:
 
 	value_type operator*() const
 	{
-		Entity entity = *m_it;
+		if (m_group)
+		{
+			Entity entity = m_group[m_position];
+
+			return value_type(entity, FetchDense<_TComponents>(entity)...);
+		}
 
-		if constexpr (IsConst)
+		Entity entity = (*m_entities)[m_position];
+
+		return value_type(entity, Fetch<_TComponents>(entity)...);
+	}
+
+	bool operator!=(const ViewIterator& other) const { return m_position != other.m_position; }
+	bool operator==(const ViewIterator& other) const { return m_position == other.m_position; }
+
+private:
+	template <typename _TComponent>
+	typename details::ViewReference<_TComponent, IsConst>::Type Fetch(Entity entity) const
+	{
+		if constexpr (details::IsShared<_TComponent>)
+		{
+			return m_manager.GetSharedValue<typename details::SharedTraits<_TComponent>::ValueType>(entity);
+		}
+		else if constexpr (IsConst)
+		{
+			return std::as_const(m_manager).GetComponent<_TComponent>(entity);
+		}
+		else
 		{
-			return std::forward_as_tuple(entity, std::as_const(m_manager).GetComponent<_TComponents>(entity)...);
+			return m_manager.GetComponent<_TComponent>(entity);
+		}
+	}
+
+	template <typename _TComponent>
+	typename details::ViewReference<_TComponent, IsConst>::Type FetchDense(Entity entity) const
+	{
+		if constexpr (details::IsShared<_TComponent>)
+		{
+			return Fetch<_TComponent>(entity);
 		}
 		else
 		{
-			return std::forward_as_tuple(entity, m_manager.GetComponent<_TComponents>(entity)...);
+			return std::get<_TComponent*>(m_components)[m_position];
 		}
 	}
 
-	bool operator!=(const ViewIterator& other) const { return m_it != other.m_it; }
-	bool operator==(const ViewIterator& other) const { return m_it == other.m_it; }
+	void SkipDisabled()
+	{
+		if (m_positions)
+		{
+			while (m_position < m_groupSize && m_disabled->Test((*m_positions)[m_group[m_position].Index()]))
+			{
+				++m_position;
+			}
+		}
+	}
 
-private:
 	ComponentManager& m_manager;
-	EntityIterator m_it;
+	std::vector<Entity> const* m_entities;
+	details::BitVector const* m_disabled;
+	std::size_t m_position;
+
+	// Grouped walk only
+	Entity const* m_group = nullptr;
+	std::size_t m_groupSize = 0;
+	std::tuple<_TComponents*...> m_components{};
+	std::vector<details::EntityIdType> const* m_positions = nullptr;
 };
 
 } // namespace Engine::ecs
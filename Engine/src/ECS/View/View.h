@@ -1,8 +1,12 @@
 #pragma once
 
+#include <limits>
 #include <ranges>
+#include <span>
+#include <tuple>
 #include <vector>
 
+#include "../BitVector/BitVector.h"
 #include "../ComponentManager/ComponentManager.h"
 #include "IView.h"
 #include "Iterator/ViewIterator.h"
@@ -23,41 +27,173 @@ public:
 	{
 	}
 
-	auto begin() { return Iterator(m_manager, m_entities.begin()); }
-	auto end() { return Iterator(m_manager, m_entities.end()); }
+	// A view over exactly the components of a group walks the group's leading range in lockstep
+	auto begin() { return MakeIterator<Iterator>(false); }
+	auto end() { return MakeIterator<Iterator>(true); }
 
-	auto begin() const { return ConstIterator(m_manager, m_entities.cbegin()); }
-	auto end() const { return ConstIterator(m_manager, m_entities.cend()); }
+	auto begin() const { return MakeIterator<ConstIterator>(false); }
+	auto end() const { return MakeIterator<ConstIterator>(true); }
 
-	void AddEntity(Entity entity)
+	// Visits enabled entities bucketed by their shared value, e.g. to batch draws by material
+	template <typename _TValue, typename _TFunc>
+	void ForEachGroup(_TFunc&& func)
 	{
+		static_assert((std::is_same_v<Shared<_TValue>, _TComponents> || ...),
+			"View does not contain Shared<_TValue>");
+
+		auto const& table = m_manager.GetSharedTable<_TValue>();
+
+		m_groupOffsets.assign(table.Capacity() + 1, 0);
+		m_groupEntities.resize(m_entities.size());
+
+		for (std::size_t i = m_disabled.NextUnset(0); i < m_entities.size(); i = m_disabled.NextUnset(i + 1))
+		{
+			m_groupOffsets[m_manager.GetComponent<Shared<_TValue>>(m_entities[i]).Handle + 1]++;
+		}
+
+		for (std::size_t handle = 1; handle < m_groupOffsets.size(); ++handle)
+		{
+			m_groupOffsets[handle] += m_groupOffsets[handle - 1];
+		}
+
+		m_groupCursor.assign(m_groupOffsets.begin(), m_groupOffsets.end() - 1);
+		for (std::size_t i = m_disabled.NextUnset(0); i < m_entities.size(); i = m_disabled.NextUnset(i + 1))
+		{
+			m_groupEntities[m_groupCursor[m_manager.GetComponent<Shared<_TValue>>(m_entities[i]).Handle]++] = m_entities[i];
+		}
+
+		for (SharedHandle handle = 0; handle + 1 < m_groupOffsets.size(); ++handle)
+		{
+			const std::size_t first = m_groupOffsets[handle];
+			const std::size_t last = m_groupOffsets[handle + 1];
+
+			if (first != last)
+			{
+				func(table.Get(handle), std::span<Entity const>(m_groupEntities.data() + first, last - first));
+			}
+		}
+	}
+
+	void AddEntity(Entity entity, Signature disabled)
+	{
+		const auto index = entity.Index();
+
+		if (index >= m_positions.size())
+		{
+			m_positions.resize(index + 1, InvalidPosition);
+		}
+
+		m_positions[index] = static_cast<Position>(m_entities.size());
 		m_entities.push_back(entity);
+		m_disabled.PushBack((disabled & m_signature).any());
 	}
 
 	void OnEntityDestroyed(Entity entity) override
 	{
-		std::erase(m_entities, entity);
+		if (Contains(entity))
+		{
+			RemoveEntity(entity);
+		}
 	}
 
-	void OnEntitySignatureChanged(Entity entity, Signature entitySignature) override
+	void OnEntitySignatureChanged(Entity entity, Signature entitySignature, Signature disabled) override
 	{
+		const bool contains = Contains(entity);
+
 		if ((entitySignature & m_signature) == m_signature)
 		{
-			if (std::ranges::find(m_entities, entity) == m_entities.end())
+			if (!contains)
 			{
-				m_entities.push_back(entity);
+				AddEntity(entity, disabled);
+			}
+			else
+			{
+				m_disabled.Set(m_positions[entity.Index()], (disabled & m_signature).any());
 			}
 		}
-		else
+		else if (contains)
 		{
-			std::erase(m_entities, entity);
+			RemoveEntity(entity);
 		}
 	}
 
+	// Follows the dense order of the first component's pool so iteration walks it linearly
+	void OnComponentsReordered() override
+	{
+		using Leading = std::tuple_element_t<0, std::tuple<_TComponents...>>;
+
+		std::vector<Entity> entities;
+		details::BitVector disabled;
+		entities.reserve(m_entities.size());
+
+		for (Entity entity : m_manager.GetEntities<Leading>())
+		{
+			if (Contains(entity))
+			{
+				entities.push_back(entity);
+				disabled.PushBack(m_disabled.Test(m_positions[entity.Index()]));
+			}
+		}
+
+		for (size_t position = 0; position < entities.size(); ++position)
+		{
+			m_positions[entities[position].Index()] = static_cast<Position>(position);
+		}
+
+		m_entities = std::move(entities);
+		m_disabled = std::move(disabled);
+	}
+
+private:
+	using Position = details::EntityIdType;
+
+	static constexpr Position InvalidPosition = std::numeric_limits<Position>::max();
+
+	template <typename _TIterator>
+	_TIterator MakeIterator(bool end) const
+	{
+		if (auto size = m_manager.GetGroupSize(m_signature))
+		{
+			using Leading = std::tuple_element_t<0, std::tuple<_TComponents...>>;
+
+			std::span<Entity const> group = m_manager.GetEntities<Leading>().first(*size);
+			return _TIterator(m_manager, group, m_disabled.Any() ? &m_positions : nullptr, m_disabled, end ? *size : 0);
+		}
+
+		return _TIterator(m_manager, m_entities, m_disabled, end ? m_entities.size() : m_disabled.NextUnset(0));
+	}
+
+	bool Contains(Entity entity) const
+	{
+		const auto index = entity.Index();
+		return index < m_positions.size()
+			&& m_positions[index] != InvalidPosition
+			&& m_entities[m_positions[index]] == entity;
+	}
+
+	void RemoveEntity(Entity entity)
+	{
+		const Position position = m_positions[entity.Index()];
+		Entity lastEntity = m_entities.back();
+
+		m_entities[position] = lastEntity;
+		m_positions[lastEntity.Index()] = position;
+		m_disabled.SwapRemove(position);
+
+		m_positions[entity.Index()] = InvalidPosition;
+		m_entities.pop_back();
+	}
+
 private:
 	ComponentManager& m_manager;
 	Signature m_signature;
 	std::vector<Entity> m_entities;
+	std::vector<Position> m_positions;
+	details::BitVector m_disabled;
+
+	std::vector<std::size_t> m_groupOffsets;
+	std::vector<std::size_t> m_groupCursor;
+	std::vector<Entity> m_groupEntities;
 };
 
 } // namespace Engine::ecs
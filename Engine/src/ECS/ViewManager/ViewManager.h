@@ -18,7 +18,9 @@ public:
 
 	void OnEntityDestroyed(Entity entity);
 
-	void OnEntitySignatureChanged(Entity entity, Signature signature);
+	void OnEntitySignatureChanged(Entity entity, Signature signature, Signature disabled);
+
+	void OnComponentsReordered();
 
 private:
 	template <typename... _TComponents>
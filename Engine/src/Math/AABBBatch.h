@@ -0,0 +1,217 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#if defined(__AVX2__)
+#define ENGINE_AABB_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENGINE_AABB_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "Vector2.h"
+
+namespace Engine::math
+{
+
+namespace details
+{
+
+// Bit i is set when box overlaps box i of the eight starting at the given pointers. Same inclusive
+// test as AABB::Intersects; AVX2 takes all eight at once, SSE2 four, otherwise one by one.
+inline std::uint32_t OverlapMask8(
+	AABB const& box, float const* minX, float const* minY, float const* maxX, float const* maxY)
+{
+#if ENGINE_AABB_AVX2
+	const __m256 overlapX = _mm256_and_ps(
+		_mm256_cmp_ps(_mm256_set1_ps(box.Min.X), _mm256_loadu_ps(maxX), _CMP_LE_OQ),
+		_mm256_cmp_ps(_mm256_set1_ps(box.Max.X), _mm256_loadu_ps(minX), _CMP_GE_OQ));
+	const __m256 overlapY = _mm256_and_ps(
+		_mm256_cmp_ps(_mm256_set1_ps(box.Min.Y), _mm256_loadu_ps(maxY), _CMP_LE_OQ),
+		_mm256_cmp_ps(_mm256_set1_ps(box.Max.Y), _mm256_loadu_ps(minY), _CMP_GE_OQ));
+	return static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_and_ps(overlapX, overlapY)));
+#elif ENGINE_AABB_SSE2
+	const __m128 boxMinX = _mm_set1_ps(box.Min.X);
+	const __m128 boxMinY = _mm_set1_ps(box.Min.Y);
+	const __m128 boxMaxX = _mm_set1_ps(box.Max.X);
+	const __m128 boxMaxY = _mm_set1_ps(box.Max.Y);
+
+	std::uint32_t mask = 0;
+	for (int half = 0; half < 2; ++half)
+	{
+		const int offset = half * 4;
+		const __m128 overlapX = _mm_and_ps(
+			_mm_cmple_ps(boxMinX, _mm_loadu_ps(maxX + offset)),
+			_mm_cmpge_ps(boxMaxX, _mm_loadu_ps(minX + offset)));
+		const __m128 overlapY = _mm_and_ps(
+			_mm_cmple_ps(boxMinY, _mm_loadu_ps(maxY + offset)),
+			_mm_cmpge_ps(boxMaxY, _mm_loadu_ps(minY + offset)));
+		mask |= static_cast<std::uint32_t>(_mm_movemask_ps(_mm_and_ps(overlapX, overlapY))) << offset;
+	}
+	return mask;
+#else
+	std::uint32_t mask = 0;
+	for (int i = 0; i < 8; ++i)
+	{
+		// Non short-circuit ands, the compiler can vectorize a loop without branches
+		const bool overlap = (box.Min.X <= maxX[i]) & (box.Max.X >= minX[i]) & (box.Min.Y <= maxY[i]) & (box.Max.Y >= minY[i]);
+		mask |= static_cast<std::uint32_t>(overlap) << i;
+	}
+	return mask;
+#endif
+}
+
+} // namespace details
+
+// Boxes in structure of arrays layout for testing one box against many, eight per step.
+// Storage is padded to whole blocks with boxes that overlap nothing.
+class AABBBatch
+{
+public:
+	static constexpr size_t BlockSize = 8;
+
+	void Clear()
+	{
+		m_size = 0;
+		m_minX.clear();
+		m_minY.clear();
+		m_maxX.clear();
+		m_maxY.clear();
+	}
+
+	void Reserve(size_t count)
+	{
+		const size_t padded = Padded(count);
+		m_minX.reserve(padded);
+		m_minY.reserve(padded);
+		m_maxX.reserve(padded);
+		m_maxY.reserve(padded);
+	}
+
+	void Add(AABB const& box)
+	{
+		if (m_size == m_minX.size())
+		{
+			AddEmptyBlock();
+		}
+		Set(m_size++, box);
+	}
+
+	// Moves the last box to index and drops it, keeping the batch dense
+	void RemoveSwap(size_t index)
+	{
+		assert(index < m_size && "Index out of range");
+
+		Set(index, Get(m_size - 1));
+		Set(--m_size, Empty);
+	}
+
+	void Set(size_t index, AABB const& box)
+	{
+		m_minX[index] = box.Min.X;
+		m_minY[index] = box.Min.Y;
+		m_maxX[index] = box.Max.X;
+		m_maxY[index] = box.Max.Y;
+	}
+
+	AABB Get(size_t index) const
+	{
+		return { { m_minX[index], m_minY[index] }, { m_maxX[index], m_maxY[index] } };
+	}
+
+	size_t Size() const
+	{
+		return m_size;
+	}
+
+	size_t BlockCount() const
+	{
+		return m_minX.size() / BlockSize;
+	}
+
+	// Overlaps of box with the boxes of one block, bit i for box block * BlockSize + i
+	std::uint32_t OverlapMask(AABB const& box, size_t block) const
+	{
+		const size_t first = block * BlockSize;
+		return details::OverlapMask8(box, &m_minX[first], &m_minY[first], &m_maxX[first], &m_maxY[first]);
+	}
+
+	// Bit i % 64 of bits[i / 64] is set when box overlaps box i, bits needs (Size() + 63) / 64 words
+	void Overlaps(AABB const& box, std::span<std::uint64_t> bits) const
+	{
+		assert(bits.size() * 64 >= m_size && "Bitmask too small");
+
+		for (std::uint64_t& word : bits)
+		{
+			word = 0;
+		}
+
+		for (size_t block = 0; block < BlockCount(); ++block)
+		{
+			bits[block / 8] |= static_cast<std::uint64_t>(OverlapMask(box, block)) << (block % 8 * BlockSize);
+		}
+	}
+
+	// Calls callback(index) for every box in [begin, end) that overlaps box, in index order
+	template <typename _TCallback>
+	void ForEachOverlap(AABB const& box, size_t begin, size_t end, _TCallback&& callback) const
+	{
+		assert(end <= m_size && "Range out of bounds");
+
+		for (size_t block = begin / BlockSize; block * BlockSize < end; ++block)
+		{
+			const size_t first = block * BlockSize;
+			std::uint32_t mask = OverlapMask(box, block);
+
+			// Boxes of the block outside the range
+			if (first < begin)
+			{
+				mask &= ~0u << (begin - first);
+			}
+			if (first + BlockSize > end)
+			{
+				mask &= (1u << (end - first)) - 1;
+			}
+
+			while (mask != 0)
+			{
+				callback(first + std::countr_zero(mask));
+				mask &= mask - 1;
+			}
+		}
+	}
+
+private:
+	// Fails every overlap test, also against another empty box
+	static constexpr AABB Empty = {
+		{ std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() },
+		{ -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity() }
+	};
+
+	static size_t Padded(size_t count)
+	{
+		return (count + BlockSize - 1) / BlockSize * BlockSize;
+	}
+
+	void AddEmptyBlock()
+	{
+		m_minX.resize(m_minX.size() + BlockSize, Empty.Min.X);
+		m_minY.resize(m_minY.size() + BlockSize, Empty.Min.Y);
+		m_maxX.resize(m_maxX.size() + BlockSize, Empty.Max.X);
+		m_maxY.resize(m_maxY.size() + BlockSize, Empty.Max.Y);
+	}
+
+	size_t m_size = 0;
+	std::vector<float> m_minX;
+	std::vector<float> m_minY;
+	std::vector<float> m_maxX;
+	std::vector<float> m_maxY;
+};
+
+} // namespace Engine::math
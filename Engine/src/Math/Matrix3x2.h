@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cmath>
+
+#include "Vector2.h"
+
+namespace Engine::math
+{
+
+// 2D affine transform: 2x2 linear part applied to column vectors, followed by a translation
+struct Matrix3x2
+{
+	float M11 = 1.0f, M12 = 0.0f;
+	float M21 = 0.0f, M22 = 1.0f;
+	Vector2 Translation = { 0.0f, 0.0f };
+
+	static Matrix3x2 FromTransform(Vector2 const& position, float rotation, Vector2 const& scale)
+	{
+		const float c = std::cos(rotation);
+		const float s = std::sin(rotation);
+
+		return Matrix3x2{
+			c * scale.X, -s * scale.Y,
+			s * scale.X, c * scale.Y,
+			position
+		};
+	}
+
+	Vector2 TransformPoint(Vector2 const& point) const
+	{
+		return {
+			M11 * point.X + M12 * point.Y + Translation.X,
+			M21 * point.X + M22 * point.Y + Translation.Y
+		};
+	}
+};
+
+// Composes so that (lhs * rhs).TransformPoint(p) == lhs.TransformPoint(rhs.TransformPoint(p))
+inline Matrix3x2 operator*(Matrix3x2 const& lhs, Matrix3x2 const& rhs)
+{
+	return Matrix3x2{
+		lhs.M11 * rhs.M11 + lhs.M12 * rhs.M21, lhs.M11 * rhs.M12 + lhs.M12 * rhs.M22,
+		lhs.M21 * rhs.M11 + lhs.M22 * rhs.M21, lhs.M21 * rhs.M12 + lhs.M22 * rhs.M22,
+		lhs.TransformPoint(rhs.Translation)
+	};
+}
+
+} // namespace Engine::math
@@ -26,6 +26,8 @@ struct Vector2
 		Y *= scalar;
 		return *this;
 	}
+
+	bool operator==(Vector2 const& rhs) const = default;
 };
 
 inline Vector2 operator+(Vector2 lhs, Vector2 const& rhs)
@@ -64,6 +66,19 @@ struct AABB
 			return false;
 		return true;
 	}
+
+	bool Contains(const AABB& other) const
+	{
+		return Min.X <= other.Min.X && Min.Y <= other.Min.Y && other.Max.X <= Max.X && other.Max.Y <= Max.Y;
+	}
+
+	float Perimeter() const { return 2.f * ((Max.X - Min.X) + (Max.Y - Min.Y)); }
 };
 
+inline AABB Union(const AABB& a, const AABB& b)
+{
+	return { { a.Min.X < b.Min.X ? a.Min.X : b.Min.X, a.Min.Y < b.Min.Y ? a.Min.Y : b.Min.Y },
+		{ a.Max.X > b.Max.X ? a.Max.X : b.Max.X, a.Max.Y > b.Max.Y ? a.Max.Y : b.Max.Y } };
+}
+
 } // namespace Engine::math
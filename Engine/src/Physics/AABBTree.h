@@ -0,0 +1,502 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "../Math/Vector2.h"
+
+namespace Engine::physics
+{
+
+namespace details
+{
+
+// Traversal stack that lives on the call stack, so queries on a shared tree don't allocate or
+// share state. Its depth stays below the tree height plus one.
+class NodeStack
+{
+public:
+	void Push(std::int32_t node)
+	{
+		assert(m_size < Capacity && "Tree too deep");
+		m_nodes[m_size++] = node;
+	}
+
+	std::int32_t Pop()
+	{
+		return m_nodes[--m_size];
+	}
+
+	bool IsEmpty() const
+	{
+		return m_size == 0;
+	}
+
+private:
+	// The rotations keep the height near 1.44 * log2 of the leaf count
+	static constexpr size_t Capacity = 256;
+
+	std::int32_t m_nodes[Capacity];
+	size_t m_size = 0;
+};
+
+} // namespace details
+
+// Dynamic bounding volume tree. Leaves hold bounds grown by a margin, so a body moving less than
+// the margin keeps its leaf. New leaves go where they grow the total perimeter the least and
+// rotations keep the heights of sibling subtrees within one of each other.
+class AABBTree
+{
+public:
+	static constexpr std::int32_t NullNode = -1;
+
+	explicit AABBTree(float margin = 10.f)
+		: m_margin(margin)
+	{
+		assert(margin >= 0.f && "Margin can't be negative");
+	}
+
+	// Returns the leaf, userData is handed back to query callbacks
+	std::int32_t CreateProxy(math::AABB const& bounds, std::uint32_t userData)
+	{
+		const std::int32_t leaf = AllocateNode();
+		m_nodes[leaf].Bounds = Fatten(bounds);
+		m_nodes[leaf].UserData = userData;
+		m_nodes[leaf].Height = 0;
+
+		InsertLeaf(leaf);
+		m_proxyCount++;
+		return leaf;
+	}
+
+	void DestroyProxy(std::int32_t proxy)
+	{
+		assert(m_nodes[proxy].IsLeaf() && "Not a proxy");
+
+		RemoveLeaf(proxy);
+		FreeNode(proxy);
+		m_proxyCount--;
+	}
+
+	// Reinserts the leaf when bounds left its fat bounds, returns whether it did
+	bool MoveProxy(std::int32_t proxy, math::AABB const& bounds)
+	{
+		assert(m_nodes[proxy].IsLeaf() && "Not a proxy");
+
+		if (m_nodes[proxy].Bounds.Contains(bounds))
+		{
+			return false;
+		}
+
+		RemoveLeaf(proxy);
+		m_nodes[proxy].Bounds = Fatten(bounds);
+		InsertLeaf(proxy);
+		return true;
+	}
+
+	std::uint32_t GetUserData(std::int32_t proxy) const
+	{
+		return m_nodes[proxy].UserData;
+	}
+
+	math::AABB const& GetFatBounds(std::int32_t proxy) const
+	{
+		return m_nodes[proxy].Bounds;
+	}
+
+	// Calls callback(userData) for every leaf whose fat bounds overlap bounds, until it returns false
+	template <typename _TCallback>
+	void Query(math::AABB const& bounds, _TCallback&& callback) const
+	{
+		Traverse([&](math::AABB const& nodeBounds) { return nodeBounds.Intersects(bounds); }, callback);
+	}
+
+	// Depth first walk into the nodes whose fat bounds pass visit(bounds), calling leaf(userData)
+	// on the leaves until it returns false. visit is asked again for every node, so its answer
+	// may tighten during the walk.
+	template <typename _TVisit, typename _TLeaf>
+	void Traverse(_TVisit&& visit, _TLeaf&& leaf) const
+	{
+		details::NodeStack stack;
+		stack.Push(m_root);
+
+		while (!stack.IsEmpty())
+		{
+			const std::int32_t index = stack.Pop();
+			if (index == NullNode)
+			{
+				continue;
+			}
+
+			Node const& node = m_nodes[index];
+			if (!visit(node.Bounds))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				if (!leaf(node.UserData))
+				{
+					return;
+				}
+			}
+			else
+			{
+				stack.Push(node.Child1);
+				stack.Push(node.Child2);
+			}
+		}
+	}
+
+	// Walks the leaves hit by origin + t * direction for t in [0, maxFraction]. callback(userData, maxFraction)
+	// returns the new maxFraction: 0 stops, a smaller value clips the ray, maxFraction goes on.
+	template <typename _TCallback>
+	void Raycast(math::Vector2 const& origin, math::Vector2 const& direction, float maxFraction, _TCallback&& callback) const
+	{
+		Traverse(
+			[&](math::AABB const& nodeBounds) { return RayEntry(nodeBounds, origin, direction, maxFraction) >= 0.f; },
+			[&](std::uint32_t userData) {
+				maxFraction = callback(userData, maxFraction);
+				return maxFraction > 0.f;
+			});
+	}
+
+	// Fraction of the ray where it enters bounds, negative on a miss
+	static float RayEntry(math::AABB const& bounds, math::Vector2 const& origin, math::Vector2 const& direction, float maxFraction)
+	{
+		float entry = 0.f;
+		float exit = maxFraction;
+
+		const float origins[2] = { origin.X, origin.Y };
+		const float directions[2] = { direction.X, direction.Y };
+		const float mins[2] = { bounds.Min.X, bounds.Min.Y };
+		const float maxs[2] = { bounds.Max.X, bounds.Max.Y };
+
+		for (int axis = 0; axis < 2; ++axis)
+		{
+			if (directions[axis] == 0.f)
+			{
+				if (origins[axis] < mins[axis] || origins[axis] > maxs[axis])
+				{
+					return -1.f;
+				}
+				continue;
+			}
+
+			const float inverse = 1.f / directions[axis];
+			float low = (mins[axis] - origins[axis]) * inverse;
+			float high = (maxs[axis] - origins[axis]) * inverse;
+			if (low > high)
+			{
+				std::swap(low, high);
+			}
+
+			entry = std::max(entry, low);
+			exit = std::min(exit, high);
+			if (entry > exit)
+			{
+				return -1.f;
+			}
+		}
+
+		return entry;
+	}
+
+	// Normal of the face a ray from outside bounds enters through, the slab it enters last
+	static math::Vector2 EntryNormal(math::AABB const& bounds, math::Vector2 const& origin, math::Vector2 const& direction)
+	{
+		auto entry = [](float min, float max, float origin, float direction) {
+			if (direction == 0.f)
+			{
+				return -std::numeric_limits<float>::infinity();
+			}
+			return ((direction > 0.f ? min : max) - origin) / direction;
+		};
+
+		if (entry(bounds.Min.X, bounds.Max.X, origin.X, direction.X) >= entry(bounds.Min.Y, bounds.Max.Y, origin.Y, direction.Y))
+		{
+			return { direction.X > 0.f ? -1.f : 1.f, 0.f };
+		}
+		return { 0.f, direction.Y > 0.f ? -1.f : 1.f };
+	}
+
+	std::int32_t GetRoot() const
+	{
+		return m_root;
+	}
+
+	std::int32_t GetHeight() const
+	{
+		return m_root == NullNode ? 0 : m_nodes[m_root].Height;
+	}
+
+	size_t GetProxyCount() const
+	{
+		return m_proxyCount;
+	}
+
+	float GetMargin() const
+	{
+		return m_margin;
+	}
+
+private:
+	struct Node
+	{
+		math::AABB Bounds;
+		std::uint32_t UserData = 0;
+		// Next free node while on the free list
+		std::int32_t Parent = NullNode;
+		std::int32_t Child1 = NullNode;
+		std::int32_t Child2 = NullNode;
+		// Leaves are 0, free nodes -1
+		std::int32_t Height = -1;
+
+		bool IsLeaf() const { return Child1 == NullNode; }
+	};
+
+	math::AABB Fatten(math::AABB const& bounds) const
+	{
+		return { { bounds.Min.X - m_margin, bounds.Min.Y - m_margin }, { bounds.Max.X + m_margin, bounds.Max.Y + m_margin } };
+	}
+
+	std::int32_t AllocateNode()
+	{
+		std::int32_t index;
+		if (m_freeList != NullNode)
+		{
+			index = m_freeList;
+			m_freeList = m_nodes[index].Parent;
+		}
+		else
+		{
+			index = static_cast<std::int32_t>(m_nodes.size());
+			m_nodes.emplace_back();
+		}
+
+		m_nodes[index] = Node{};
+		return index;
+	}
+
+	void FreeNode(std::int32_t index)
+	{
+		m_nodes[index].Parent = m_freeList;
+		m_nodes[index].Height = -1;
+		m_freeList = index;
+	}
+
+	// Descends towards the sibling with the lowest cost, where the cost of a subtree is the perimeter
+	// it would gain plus the perimeter its ancestors already gained
+	std::int32_t FindBestSibling(math::AABB const& leafBounds) const
+	{
+		std::int32_t index = m_root;
+		while (!m_nodes[index].IsLeaf())
+		{
+			Node const& node = m_nodes[index];
+
+			const float perimeter = node.Bounds.Perimeter();
+			const float combinedPerimeter = math::Union(node.Bounds, leafBounds).Perimeter();
+
+			// Pairing with this node creates a parent with the combined bounds
+			const float cost = 2.f * combinedPerimeter;
+			const float inheritanceCost = 2.f * (combinedPerimeter - perimeter);
+
+			auto childCost = [&](std::int32_t child) {
+				Node const& childNode = m_nodes[child];
+				const float grown = math::Union(childNode.Bounds, leafBounds).Perimeter();
+				return (childNode.IsLeaf() ? grown : grown - childNode.Bounds.Perimeter()) + inheritanceCost;
+			};
+
+			const float cost1 = childCost(node.Child1);
+			const float cost2 = childCost(node.Child2);
+
+			if (cost < cost1 && cost < cost2)
+			{
+				break;
+			}
+
+			index = cost1 < cost2 ? node.Child1 : node.Child2;
+		}
+
+		return index;
+	}
+
+	void InsertLeaf(std::int32_t leaf)
+	{
+		if (m_root == NullNode)
+		{
+			m_root = leaf;
+			m_nodes[leaf].Parent = NullNode;
+			return;
+		}
+
+		const math::AABB leafBounds = m_nodes[leaf].Bounds;
+		const std::int32_t sibling = FindBestSibling(leafBounds);
+
+		const std::int32_t oldParent = m_nodes[sibling].Parent;
+		const std::int32_t newParent = AllocateNode();
+
+		m_nodes[newParent].Parent = oldParent;
+		m_nodes[newParent].Bounds = math::Union(leafBounds, m_nodes[sibling].Bounds);
+		m_nodes[newParent].Height = m_nodes[sibling].Height + 1;
+		m_nodes[newParent].Child1 = sibling;
+		m_nodes[newParent].Child2 = leaf;
+		m_nodes[sibling].Parent = newParent;
+		m_nodes[leaf].Parent = newParent;
+
+		if (oldParent == NullNode)
+		{
+			m_root = newParent;
+		}
+		else if (m_nodes[oldParent].Child1 == sibling)
+		{
+			m_nodes[oldParent].Child1 = newParent;
+		}
+		else
+		{
+			m_nodes[oldParent].Child2 = newParent;
+		}
+
+		Refit(m_nodes[leaf].Parent);
+	}
+
+	void RemoveLeaf(std::int32_t leaf)
+	{
+		if (leaf == m_root)
+		{
+			m_root = NullNode;
+			return;
+		}
+
+		const std::int32_t parent = m_nodes[leaf].Parent;
+		const std::int32_t grandParent = m_nodes[parent].Parent;
+		const std::int32_t sibling = m_nodes[parent].Child1 == leaf ? m_nodes[parent].Child2 : m_nodes[parent].Child1;
+
+		FreeNode(parent);
+		m_nodes[sibling].Parent = grandParent;
+
+		if (grandParent == NullNode)
+		{
+			m_root = sibling;
+			return;
+		}
+
+		if (m_nodes[grandParent].Child1 == parent)
+		{
+			m_nodes[grandParent].Child1 = sibling;
+		}
+		else
+		{
+			m_nodes[grandParent].Child2 = sibling;
+		}
+
+		Refit(grandParent);
+	}
+
+	// Rebalances and refits every node from index up to the root
+	void Refit(std::int32_t index)
+	{
+		while (index != NullNode)
+		{
+			index = Balance(index);
+
+			Node& node = m_nodes[index];
+			Node const& child1 = m_nodes[node.Child1];
+			Node const& child2 = m_nodes[node.Child2];
+			node.Height = 1 + std::max(child1.Height, child2.Height);
+			node.Bounds = math::Union(child1.Bounds, child2.Bounds);
+
+			index = node.Parent;
+		}
+	}
+
+	// Rotates the taller child of a up when the heights of its children differ by more than one,
+	// returns the node now at the position of a
+	std::int32_t Balance(std::int32_t a)
+	{
+		Node& nodeA = m_nodes[a];
+		if (nodeA.IsLeaf() || nodeA.Height < 2)
+		{
+			return a;
+		}
+
+		const std::int32_t b = nodeA.Child1;
+		const std::int32_t c = nodeA.Child2;
+		const std::int32_t balance = m_nodes[c].Height - m_nodes[b].Height;
+
+		if (balance > 1)
+		{
+			Rotate(a, c, b, false);
+			return c;
+		}
+
+		if (balance < -1)
+		{
+			Rotate(a, b, c, true);
+			return b;
+		}
+
+		return a;
+	}
+
+	// Puts up in place of a with a as its first child; a keeps the stay child and takes the
+	// shorter child of up, up keeps the taller one
+	void Rotate(std::int32_t a, std::int32_t up, std::int32_t stay, bool upIsChild1)
+	{
+		Node& nodeA = m_nodes[a];
+		Node& nodeUp = m_nodes[up];
+
+		const std::int32_t f = nodeUp.Child1;
+		const std::int32_t g = nodeUp.Child2;
+
+		nodeUp.Child1 = a;
+		nodeUp.Parent = nodeA.Parent;
+		nodeA.Parent = up;
+
+		if (nodeUp.Parent == NullNode)
+		{
+			m_root = up;
+		}
+		else if (m_nodes[nodeUp.Parent].Child1 == a)
+		{
+			m_nodes[nodeUp.Parent].Child1 = up;
+		}
+		else
+		{
+			m_nodes[nodeUp.Parent].Child2 = up;
+		}
+
+		const bool fTaller = m_nodes[f].Height > m_nodes[g].Height;
+		const std::int32_t taller = fTaller ? f : g;
+		const std::int32_t shorter = fTaller ? g : f;
+
+		nodeUp.Child2 = taller;
+		if (upIsChild1)
+		{
+			nodeA.Child1 = shorter;
+		}
+		else
+		{
+			nodeA.Child2 = shorter;
+		}
+		m_nodes[shorter].Parent = a;
+
+		nodeA.Bounds = math::Union(m_nodes[stay].Bounds, m_nodes[shorter].Bounds);
+		nodeA.Height = 1 + std::max(m_nodes[stay].Height, m_nodes[shorter].Height);
+		nodeUp.Bounds = math::Union(nodeA.Bounds, m_nodes[taller].Bounds);
+		nodeUp.Height = 1 + std::max(nodeA.Height, m_nodes[taller].Height);
+	}
+
+	std::vector<Node> m_nodes;
+	std::int32_t m_root = NullNode;
+	std::int32_t m_freeList = NullNode;
+	size_t m_proxyCount = 0;
+	float m_margin;
+};
+
+} // namespace Engine::physics
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "../ECS/Entity/Entity.h"
+#include "../Math/AABBBatch.h"
+#include "../Math/Vector2.h"
+
+namespace Engine::physics
+{
+
+enum class BroadphaseKind
+{
+	// Tests every pair, kept as a reference for small scenes and benchmarks
+	BruteForce,
+	SpatialHash,
+	// Incremental, cheapest when bodies move a little each step
+	SweepAndPrune,
+	// Separate static and dynamic trees, for levels of large static colliders and few movers
+	AABBTree
+};
+
+enum class BodyKind : std::uint8_t
+{
+	Dynamic,
+	// Never pushed by collisions, e.g. zero mass level geometry
+	Static
+};
+
+// Indices of two proxies whose bounds overlap, First < Second
+struct BroadphasePair
+{
+	std::uint32_t First;
+	std::uint32_t Second;
+
+	bool operator==(BroadphasePair const&) const = default;
+
+	std::uint64_t Key() const
+	{
+		return (static_cast<std::uint64_t>(First) << 32) | Second;
+	}
+};
+
+// Two entities whose bounds overlap, First < Second
+struct EntityPair
+{
+	ecs::Entity First;
+	ecs::Entity Second;
+
+	auto operator<=>(EntityPair const&) const = default;
+
+	static EntityPair Make(ecs::Entity a, ecs::Entity b)
+	{
+		return a < b ? EntityPair{ a, b } : EntityPair{ b, a };
+	}
+};
+
+class IBroadphase
+{
+public:
+	virtual ~IBroadphase() = default;
+
+	// entities[i] owns bounds[i] and is of kinds[i]; entities missing since the last update are
+	// dropped. Broadphases that tell kinds apart leave out pairs of two static bodies.
+	virtual void Update(std::span<ecs::Entity const> entities, std::span<math::AABB const> bounds, std::span<BodyKind const> kinds) = 0;
+
+	// Overlapping pairs as indices into the spans of the last update, sorted
+	virtual std::span<BroadphasePair const> GetPairs() const = 0;
+
+	// Pairs that began or stopped overlapping in the last update
+	virtual std::span<EntityPair const> GetAddedPairs() const = 0;
+	virtual std::span<EntityPair const> GetRemovedPairs() const = 0;
+
+	// Independent copy holding the same bodies and pairs
+	virtual std::shared_ptr<IBroadphase> Clone() const = 0;
+};
+
+namespace details
+{
+
+// Added and removed pairs for broadphases that find every pair from scratch, by diffing the
+// sorted pair lists of consecutive updates
+class PairDiff
+{
+public:
+	void Update(std::span<ecs::Entity const> entities, std::span<BroadphasePair const> pairs)
+	{
+		m_current.clear();
+		m_current.reserve(pairs.size());
+		for (BroadphasePair const& pair : pairs)
+		{
+			m_current.push_back(EntityPair::Make(entities[pair.First], entities[pair.Second]));
+		}
+		Diff();
+	}
+
+	// Same for pairs already made of entities, in any order
+	void Update(std::span<EntityPair const> pairs)
+	{
+		m_current.assign(pairs.begin(), pairs.end());
+		Diff();
+	}
+
+	std::span<EntityPair const> GetAdded() const
+	{
+		return m_added;
+	}
+
+	std::span<EntityPair const> GetRemoved() const
+	{
+		return m_removed;
+	}
+
+private:
+	void Diff()
+	{
+		std::sort(m_current.begin(), m_current.end());
+
+		m_added.clear();
+		m_removed.clear();
+		std::set_difference(m_current.begin(), m_current.end(), m_previous.begin(), m_previous.end(), std::back_inserter(m_added));
+		std::set_difference(m_previous.begin(), m_previous.end(), m_current.begin(), m_current.end(), std::back_inserter(m_removed));
+
+		std::swap(m_previous, m_current);
+	}
+
+	std::vector<EntityPair> m_previous;
+	std::vector<EntityPair> m_current;
+	std::vector<EntityPair> m_added;
+	std::vector<EntityPair> m_removed;
+};
+
+} // namespace details
+
+class BruteForceBroadphase final : public IBroadphase
+{
+public:
+	void Update(std::span<ecs::Entity const> entities, std::span<math::AABB const> bounds, std::span<BodyKind const>) override
+	{
+		m_pairs.clear();
+
+		m_batch.Clear();
+		m_batch.Reserve(bounds.size());
+		for (math::AABB const& box : bounds)
+		{
+			m_batch.Add(box);
+		}
+
+		for (std::uint32_t i = 0; i < bounds.size(); ++i)
+		{
+			m_batch.ForEachOverlap(bounds[i], i + 1, bounds.size(), [&](size_t j) {
+				m_pairs.push_back({ i, static_cast<std::uint32_t>(j) });
+			});
+		}
+
+		m_diff.Update(entities, m_pairs);
+	}
+
+	std::span<BroadphasePair const> GetPairs() const override
+	{
+		return m_pairs;
+	}
+
+	std::span<EntityPair const> GetAddedPairs() const override
+	{
+		return m_diff.GetAdded();
+	}
+
+	std::span<EntityPair const> GetRemovedPairs() const override
+	{
+		return m_diff.GetRemoved();
+	}
+
+	std::shared_ptr<IBroadphase> Clone() const override
+	{
+		return std::make_shared<BruteForceBroadphase>(*this);
+	}
+
+private:
+	math::AABBBatch m_batch;
+	std::vector<BroadphasePair> m_pairs;
+	details::PairDiff m_diff;
+};
+
+} // namespace Engine::physics
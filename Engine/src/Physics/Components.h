@@ -1,6 +1,8 @@
 #pragma once
 #include "../ECS/Entity/Entity.h"
+#include "../Math/Matrix3x2.h"
 #include "../Math/Vector2.h"
+#include <cstdint>
 #include <limits>
 
 namespace Engine::physics::components
@@ -9,6 +11,32 @@ namespace Engine::physics::components
 struct Transform
 {
 	math::Vector2 Position = { 0.f, 0.f };
+	float Rotation = 0.f;
+	math::Vector2 Scale = { 1.f, 1.f };
+
+	bool operator==(Transform const& other) const
+	{
+		return Position.X == other.Position.X && Position.Y == other.Position.Y
+			&& Rotation == other.Rotation
+			&& Scale.X == other.Scale.X && Scale.Y == other.Scale.Y;
+	}
+};
+
+// Makes Transform local to Parent, roots of a hierarchy keep Parent invalid
+struct Hierarchy
+{
+	ecs::Entity Parent = ecs::InvalidEntity;
+};
+
+// Written by TransformSystem for entities with Transform and Hierarchy
+struct WorldTransform
+{
+	math::Matrix3x2 Matrix;
+
+	math::Vector2 Position() const
+	{
+		return Matrix.Translation;
+	}
 };
 
 struct RigidBody
@@ -17,6 +45,12 @@ struct RigidBody
 	float Mass = 1.0f;
 	float Restitution = 0.5f;
 	float LinearDamping = 10.f;
+	// Set by PhysicsSystem while the body's island rests. To wake the island, clear it or edit the body
+	// and call Scene::MarkChanged
+	bool Sleeping = false;
+	// Sweeps the body against static colliders so a fast mover can't pass through thin walls
+	// within one step
+	bool ContinuousCollision = false;
 
 	float InvertedMass() const
 	{
@@ -34,6 +68,11 @@ struct AABBCollider
 	math::Vector2 Size = { 50.0f, 50.0f };
 	math::Vector2 Position = { 0.f, 0.f };
 	math::AABB Bounds;
+	// Two colliders collide when each one's Layer shares a bit with the other's Mask
+	std::uint32_t Layer = 1;
+	std::uint32_t Mask = ~0u;
+	// Sensors aren't pushed and don't push, PhysicsSystem reports what they overlap
+	bool Sensor = false;
 
 	void MoveBounds(math::Vector2 const& position)
 	{
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+#include "../Math/Vector2.h"
+
+#include "Broadphase.h"
+
+namespace Engine::physics
+{
+
+// Normal impulses the solver accumulated per entity pair in the last step, so the next step can
+// start from them. Normals are kept from First towards Second of the pair.
+class ContactCache
+{
+public:
+	struct Entry
+	{
+		EntityPair Pair;
+		math::Vector2 Normal;
+		float NormalImpulse = 0.f;
+	};
+
+	// Impulse the pair ended the last step with, 0 for a new contact or one whose normal changed
+	float Find(EntityPair const& pair, math::Vector2 const& normal) const
+	{
+		auto it = std::lower_bound(m_entries.begin(), m_entries.end(), pair, [](Entry const& entry, EntityPair const& key) {
+			return entry.Pair < key;
+		});
+
+		if (it == m_entries.end() || it->Pair != pair || it->Normal.X != normal.X || it->Normal.Y != normal.Y)
+		{
+			return 0.f;
+		}
+
+		return it->NormalImpulse;
+	}
+
+	// Replaces the cache with the contacts of this step, pairs left out are forgotten
+	void Assign(std::span<Entry const> entries)
+	{
+		m_entries.assign(entries.begin(), entries.end());
+		std::sort(m_entries.begin(), m_entries.end(), [](Entry const& lhs, Entry const& rhs) {
+			return lhs.Pair < rhs.Pair;
+		});
+	}
+
+	void Clear()
+	{
+		m_entries.clear();
+	}
+
+	size_t Size() const
+	{
+		return m_entries.size();
+	}
+
+private:
+	// Sorted by pair, stays allocated between steps
+	std::vector<Entry> m_entries;
+};
+
+} // namespace Engine::physics
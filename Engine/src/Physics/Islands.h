@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "Broadphase.h"
+
+namespace Engine::physics::details
+{
+
+// Splits contacts into islands, groups of contacts that share dynamic bodies through a union-find.
+// Static bodies don't link islands since contacts never move them, so two islands can be solved on
+// different threads. Islands are numbered by their first contact and keep their contacts in the
+// given order, so the grouping doesn't depend on how they are solved.
+class IslandBuilder
+{
+public:
+	// contacts hold body indices below bodyCount; contacts between two static bodies join no island
+	void Build(size_t bodyCount, std::span<BroadphasePair const> contacts, std::span<BodyKind const> kinds)
+	{
+		m_parent.resize(bodyCount);
+		for (std::uint32_t body = 0; body < bodyCount; ++body)
+		{
+			m_parent[body] = body;
+		}
+
+		for (BroadphasePair const& contact : contacts)
+		{
+			if (kinds[contact.First] == BodyKind::Dynamic && kinds[contact.Second] == BodyKind::Dynamic)
+			{
+				Union(contact.First, contact.Second);
+			}
+		}
+
+		// Island of every contact, numbered in order of first appearance
+		m_islandOfRoot.assign(bodyCount, NoIsland);
+		m_islandOfContact.resize(contacts.size());
+		m_islandStart.clear();
+
+		for (size_t i = 0; i < contacts.size(); ++i)
+		{
+			BroadphasePair const& contact = contacts[i];
+			if (kinds[contact.First] == BodyKind::Static && kinds[contact.Second] == BodyKind::Static)
+			{
+				m_islandOfContact[i] = NoIsland;
+				continue;
+			}
+
+			const std::uint32_t root = Find(kinds[contact.First] == BodyKind::Dynamic ? contact.First : contact.Second);
+			if (m_islandOfRoot[root] == NoIsland)
+			{
+				m_islandOfRoot[root] = static_cast<std::uint32_t>(m_islandStart.size());
+				m_islandStart.push_back(0);
+			}
+
+			m_islandOfContact[i] = m_islandOfRoot[root];
+			m_islandStart[m_islandOfRoot[root]]++;
+		}
+
+		// Counting sort of the contacts by island, stable so each island keeps the contact order
+		std::uint32_t offset = 0;
+		for (std::uint32_t& start : m_islandStart)
+		{
+			const std::uint32_t count = start;
+			start = offset;
+			offset += count;
+		}
+		m_islandStart.push_back(offset);
+
+		m_contacts.resize(offset);
+		m_cursor.assign(m_islandStart.begin(), m_islandStart.end() - 1);
+		for (std::uint32_t i = 0; i < contacts.size(); ++i)
+		{
+			if (m_islandOfContact[i] != NoIsland)
+			{
+				m_contacts[m_cursor[m_islandOfContact[i]]++] = i;
+			}
+		}
+	}
+
+	size_t GetIslandCount() const
+	{
+		return m_islandStart.empty() ? 0 : m_islandStart.size() - 1;
+	}
+
+	// Bodies linked through contacts share a root, the lowest body index among them
+	std::uint32_t GetRoot(std::uint32_t body)
+	{
+		return Find(body);
+	}
+
+	// Indices into the contacts passed to Build, ascending
+	std::span<std::uint32_t const> GetContacts(size_t island) const
+	{
+		return std::span<std::uint32_t const>(m_contacts).subspan(m_islandStart[island], m_islandStart[island + 1] - m_islandStart[island]);
+	}
+
+private:
+	static constexpr std::uint32_t NoIsland = std::numeric_limits<std::uint32_t>::max();
+
+	std::uint32_t Find(std::uint32_t body)
+	{
+		while (m_parent[body] != body)
+		{
+			// Path halving
+			m_parent[body] = m_parent[m_parent[body]];
+			body = m_parent[body];
+		}
+		return body;
+	}
+
+	// The lower index becomes the root, the result doesn't depend on the order of unions
+	void Union(std::uint32_t a, std::uint32_t b)
+	{
+		a = Find(a);
+		b = Find(b);
+		if (a < b)
+		{
+			m_parent[b] = a;
+		}
+		else if (b < a)
+		{
+			m_parent[a] = b;
+		}
+	}
+
+	std::vector<std::uint32_t> m_parent;
+	std::vector<std::uint32_t> m_islandOfRoot;
+	std::vector<std::uint32_t> m_islandOfContact;
+	std::vector<std::uint32_t> m_islandStart;
+	std::vector<std::uint32_t> m_cursor;
+	std::vector<std::uint32_t> m_contacts;
+};
+
+} // namespace Engine::physics::details
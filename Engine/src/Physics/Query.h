@@ -0,0 +1,312 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "../ECS/Entity/Entity.h"
+#include "../Math/AABBBatch.h"
+#include "../Math/Vector2.h"
+
+#include "AABBTree.h"
+#include "Broadphase.h"
+#include "SleepingBodies.h"
+#include "TreeBroadphase.h"
+
+namespace Engine::physics
+{
+
+struct RaycastHit
+{
+	ecs::Entity Entity = ecs::InvalidEntity;
+	math::Vector2 Point;
+	// Zero when the ray starts inside the collider
+	math::Vector2 Normal;
+	// Position along the segment, 0 at from and 1 at to
+	float Fraction = 0.f;
+};
+
+struct NearestHit
+{
+	ecs::Entity Entity = ecs::InvalidEntity;
+	// Squared distance to the collider bounds, 0 inside
+	float DistanceSq = 0.f;
+};
+
+// Colliders of the last step kept in a flat list, answers queries when the broadphase has no
+// AABB tree by testing every collider. Mirrors the AABBTree traversal calls Query makes.
+class BoundsList
+{
+public:
+	void Assign(std::span<ecs::Entity const> entities, std::span<math::AABB const> bounds)
+	{
+		assert(entities.size() == bounds.size() && "Every collider needs bounds");
+
+		m_entities.assign(entities.begin(), entities.end());
+		m_bounds.assign(bounds.begin(), bounds.end());
+	}
+
+	template <typename _TVisit, typename _TLeaf>
+	void Traverse(_TVisit&& visit, _TLeaf&& leaf) const
+	{
+		for (std::uint32_t proxy = 0; proxy < m_bounds.size(); ++proxy)
+		{
+			if (visit(m_bounds[proxy]) && !leaf(proxy))
+			{
+				return;
+			}
+		}
+	}
+
+	template <typename _TCallback>
+	void Query(math::AABB const& bounds, _TCallback&& callback) const
+	{
+		Traverse([&](math::AABB const& colliderBounds) { return colliderBounds.Intersects(bounds); }, callback);
+	}
+
+	template <typename _TCallback>
+	void Raycast(math::Vector2 const& origin, math::Vector2 const& direction, float maxFraction, _TCallback&& callback) const
+	{
+		Traverse(
+			[&](math::AABB const& colliderBounds) { return AABBTree::RayEntry(colliderBounds, origin, direction, maxFraction) >= 0.f; },
+			[&](std::uint32_t proxy) {
+				maxFraction = callback(proxy, maxFraction);
+				return maxFraction > 0.f;
+			});
+	}
+
+	ecs::Entity GetEntity(std::uint32_t proxy) const
+	{
+		return m_entities[proxy];
+	}
+
+	math::AABB const& GetBounds(std::uint32_t proxy) const
+	{
+		return m_bounds[proxy];
+	}
+
+private:
+	std::vector<ecs::Entity> m_entities;
+	std::vector<math::AABB> m_bounds;
+};
+
+// Scene resource answering spatial queries about colliders from the AABB tree the PhysicsSystem
+// steps and its sleeping bodies, with the bounds of its last step. Other broadphases have no tree,
+// their colliders are tested one by one. Add it with SetResource<physics::Query>() and register
+// the physics system with WithResourceWrite<Query>() and the querying systems with
+// WithResourceRead<Query>(). Queries are const and keep no state, so any number of systems can
+// run them at once. Results go to the caller's buffers; when one fills up the query stops.
+class Query
+{
+public:
+	// Closest collider hit by the segment from, to
+	bool Raycast(math::Vector2 const& from, math::Vector2 const& to, RaycastHit& hit) const
+	{
+		if (!IsBound())
+		{
+			return false;
+		}
+
+		const math::Vector2 direction = to - from;
+		ecs::Entity closest = ecs::InvalidEntity;
+		math::AABB closestBounds;
+		float closestFraction = 1.f;
+
+		ForEachSource([&](auto const& tree, auto const& source) {
+			tree.Raycast(from, direction, closestFraction, [&](std::uint32_t proxy, float maxFraction) {
+				const float fraction = AABBTree::RayEntry(source.GetBounds(proxy), from, direction, maxFraction);
+				if (fraction < 0.f)
+				{
+					return maxFraction;
+				}
+
+				closest = source.GetEntity(proxy);
+				closestBounds = source.GetBounds(proxy);
+				closestFraction = fraction;
+				return fraction;
+			});
+			return true;
+		});
+
+		if (closest == ecs::InvalidEntity)
+		{
+			return false;
+		}
+
+		hit.Entity = closest;
+		hit.Fraction = closestFraction;
+		hit.Point = from + direction * closestFraction;
+		hit.Normal = closestFraction > 0.f ? AABBTree::EntryNormal(closestBounds, from, direction) : math::Vector2{};
+		return true;
+	}
+
+	// Colliders overlapping bounds, returns how many were written
+	size_t OverlapBox(math::AABB const& bounds, std::span<ecs::Entity> results) const
+	{
+		return Overlap(bounds, results, [](math::AABB const&) {
+			return true;
+		});
+	}
+
+	// Colliders within radius of center, returns how many were written
+	size_t OverlapCircle(math::Vector2 const& center, float radius, std::span<ecs::Entity> results) const
+	{
+		const math::AABB bounds = { { center.X - radius, center.Y - radius }, { center.X + radius, center.Y + radius } };
+
+		return Overlap(bounds, results, [&](math::AABB const& colliderBounds) {
+			return DistanceSq(center, colliderBounds) <= radius * radius;
+		});
+	}
+
+	// Up to results.size() colliders nearest to point and within maxDistance, closest first.
+	// Returns how many were written.
+	size_t Nearest(math::Vector2 const& point, std::span<NearestHit> results, float maxDistance = std::numeric_limits<float>::infinity()) const
+	{
+		if (!IsBound() || results.empty())
+		{
+			return 0;
+		}
+
+		const float maxDistanceSq = maxDistance * maxDistance;
+		size_t count = 0;
+
+		// Worst distance still worth looking at, the k-th best once the buffer is full
+		auto bound = [&]() {
+			return count < results.size() ? maxDistanceSq : results[count - 1].DistanceSq;
+		};
+
+		auto visit = [&](math::AABB const& nodeBounds) {
+			return DistanceSq(point, nodeBounds) <= bound();
+		};
+
+		ForEachSource([&](auto const& tree, auto const& source) {
+			tree.Traverse(visit, [&](std::uint32_t proxy) {
+				const float distanceSq = DistanceSq(point, source.GetBounds(proxy));
+				if (distanceSq > bound() || (count == results.size() && distanceSq == bound()))
+				{
+					return true;
+				}
+
+				// Insertion into the sorted buffer, dropping the worst one when it is full
+				size_t position = std::min(count, results.size() - 1);
+				while (position > 0 && results[position - 1].DistanceSq > distanceSq)
+				{
+					results[position] = results[position - 1];
+					--position;
+				}
+				results[position] = { source.GetEntity(proxy), distanceSq };
+				count = std::min(count + 1, results.size());
+				return true;
+			});
+			return true;
+		});
+		return count;
+	}
+
+	// False until the physics system stepped
+	bool IsBound() const
+	{
+		return m_broadphase != nullptr || m_colliders != nullptr;
+	}
+
+private:
+	friend class PhysicsSystem;
+
+	// Calls func(tree, source) for the dynamic and static trees of the broadphase, or the list of
+	// colliders without one, and the tree of sleeping bodies. source maps the proxies of tree to
+	// entities and bounds. Stops when func returns false.
+	template <typename _TFunc>
+	void ForEachSource(_TFunc&& func) const
+	{
+		const bool next = m_broadphase
+			? func(m_broadphase->GetTree(BodyKind::Dynamic), *m_broadphase) && func(m_broadphase->GetTree(BodyKind::Static), *m_broadphase)
+			: func(*m_colliders, *m_colliders);
+
+		if (next && m_sleeping)
+		{
+			func(m_sleeping->GetTree(), *m_sleeping);
+		}
+	}
+
+	static float DistanceSq(math::Vector2 const& point, math::AABB const& bounds)
+	{
+		const float dx = std::max({ bounds.Min.X - point.X, 0.f, point.X - bounds.Max.X });
+		const float dy = std::max({ bounds.Min.Y - point.Y, 0.f, point.Y - bounds.Max.Y });
+		return dx * dx + dy * dy;
+	}
+
+	// Fat bounds candidates from the trees are gathered and their tight bounds tested against
+	// bounds a block at a time, test then makes the exact check on the survivors
+	template <typename _TTest>
+	size_t Overlap(math::AABB const& bounds, std::span<ecs::Entity> results, _TTest&& test) const
+	{
+		if (!IsBound() || results.empty())
+		{
+			return 0;
+		}
+
+		constexpr size_t CandidateCount = 64;
+		constexpr float Infinity = std::numeric_limits<float>::infinity();
+
+		float minX[CandidateCount];
+		float minY[CandidateCount];
+		float maxX[CandidateCount];
+		float maxY[CandidateCount];
+		ecs::Entity entities[CandidateCount];
+		size_t candidates = 0;
+		size_t count = 0;
+
+		auto flush = [&]() {
+			// Pad the last block with boxes that overlap nothing
+			for (size_t i = candidates; i % 8 != 0; ++i)
+			{
+				minX[i] = minY[i] = Infinity;
+				maxX[i] = maxY[i] = -Infinity;
+			}
+
+			for (size_t first = 0; first < candidates && count < results.size(); first += 8)
+			{
+				std::uint32_t mask = math::details::OverlapMask8(bounds, minX + first, minY + first, maxX + first, maxY + first);
+				for (; mask != 0 && count < results.size(); mask &= mask - 1)
+				{
+					const size_t i = first + std::countr_zero(mask);
+					if (test(math::AABB{ { minX[i], minY[i] }, { maxX[i], maxY[i] } }))
+					{
+						results[count++] = entities[i];
+					}
+				}
+			}
+
+			candidates = 0;
+			return count < results.size();
+		};
+
+		ForEachSource([&](auto const& tree, auto const& source) {
+			tree.Query(bounds, [&](std::uint32_t proxy) {
+				math::AABB const& colliderBounds = source.GetBounds(proxy);
+				minX[candidates] = colliderBounds.Min.X;
+				minY[candidates] = colliderBounds.Min.Y;
+				maxX[candidates] = colliderBounds.Max.X;
+				maxY[candidates] = colliderBounds.Max.Y;
+				entities[candidates++] = source.GetEntity(proxy);
+
+				return candidates < CandidateCount || flush();
+			});
+			return flush();
+		});
+		return count;
+	}
+
+	// Shared so a query never outlives the broadphase it reads, even across SetSettings.
+	// Only one of the two is set.
+	std::shared_ptr<TreeBroadphase const> m_broadphase;
+	std::shared_ptr<BoundsList const> m_colliders;
+	std::shared_ptr<SleepingBodies const> m_sleeping;
+};
+
+} // namespace Engine::physics
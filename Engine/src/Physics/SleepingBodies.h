@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "../ECS/Entity/Entity.h"
+#include "../Math/Vector2.h"
+
+#include "AABBTree.h"
+
+namespace Engine::physics
+{
+
+// Colliders of sleeping islands. They don't move while they sleep, so they live in a tree of
+// their own between steps instead of going through the broadphase every step. Leaves carry the
+// entity index, GetEntity and GetBounds look it up.
+class SleepingBodies
+{
+public:
+	void Insert(ecs::Entity entity, math::AABB const& bounds)
+	{
+		const size_t index = entity.Index();
+		if (index >= m_proxies.size())
+		{
+			m_proxies.resize(index + 1);
+		}
+
+		// A reused entity index replaces the body it belonged to
+		Proxy& proxy = m_proxies[index];
+		if (proxy.Node != AABBTree::NullNode)
+		{
+			m_tree.DestroyProxy(proxy.Node);
+		}
+
+		proxy = { entity, bounds, m_tree.CreateProxy(bounds, static_cast<std::uint32_t>(index)) };
+	}
+
+	void Remove(ecs::Entity entity)
+	{
+		assert(Contains(entity) && "Body isn't sleeping");
+
+		Proxy& proxy = m_proxies[entity.Index()];
+		m_tree.DestroyProxy(proxy.Node);
+		proxy = {};
+	}
+
+	bool Contains(ecs::Entity entity) const
+	{
+		return entity.Index() < m_proxies.size() && m_proxies[entity.Index()].Entity == entity;
+	}
+
+	// Removes the bodies remove(entity) returns true for
+	template <typename _TPredicate>
+	void RemoveIf(_TPredicate&& remove)
+	{
+		for (Proxy& proxy : m_proxies)
+		{
+			if (proxy.Node != AABBTree::NullNode && remove(proxy.Entity))
+			{
+				m_tree.DestroyProxy(proxy.Node);
+				proxy = {};
+			}
+		}
+	}
+
+	AABBTree const& GetTree() const
+	{
+		return m_tree;
+	}
+
+	ecs::Entity GetEntity(std::uint32_t proxy) const
+	{
+		return m_proxies[proxy].Entity;
+	}
+
+	math::AABB const& GetBounds(std::uint32_t proxy) const
+	{
+		return m_proxies[proxy].Bounds;
+	}
+
+private:
+	struct Proxy
+	{
+		ecs::Entity Entity = ecs::InvalidEntity;
+		math::AABB Bounds;
+		std::int32_t Node = AABBTree::NullNode;
+	};
+
+	// Sleeping bodies never move, their leaves need no margin
+	AABBTree m_tree{ 0.f };
+
+	// Indexed by entity index
+	std::vector<Proxy> m_proxies;
+};
+
+} // namespace Engine::physics
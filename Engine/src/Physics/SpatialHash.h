@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "../ECS/Entity/Entity.h"
+#include "../Math/Vector2.h"
+
+#include "Broadphase.h"
+
+namespace Engine::physics
+{
+
+// Uniform grid hashed into a flat table, rebuilt from the bounds every step with a counting sort.
+// A box is inserted into every cell it touches; a cell size around the typical box size keeps
+// that at one to four cells per box.
+class SpatialHash final : public IBroadphase
+{
+public:
+	explicit SpatialHash(float cellSize = 100.f)
+	{
+		SetCellSize(cellSize);
+	}
+
+	void SetCellSize(float cellSize)
+	{
+		assert(cellSize > 0.f && "Cell size must be positive");
+		m_cellSize = cellSize;
+		m_inverseCellSize = 1.f / cellSize;
+	}
+
+	float GetCellSize() const
+	{
+		return m_cellSize;
+	}
+
+	void Update(std::span<ecs::Entity const> entities, std::span<math::AABB const> bounds, std::span<BodyKind const>) override
+	{
+		m_pairs.clear();
+		Build(bounds);
+		FindPairs(bounds, m_pairs);
+
+		m_diff.Update(entities, m_pairs);
+	}
+
+	std::span<BroadphasePair const> GetPairs() const override
+	{
+		return m_pairs;
+	}
+
+	std::span<EntityPair const> GetAddedPairs() const override
+	{
+		return m_diff.GetAdded();
+	}
+
+	std::span<EntityPair const> GetRemovedPairs() const override
+	{
+		return m_diff.GetRemoved();
+	}
+
+	std::shared_ptr<IBroadphase> Clone() const override
+	{
+		return std::make_shared<SpatialHash>(*this);
+	}
+
+	void Build(std::span<math::AABB const> bounds)
+	{
+		m_cells.clear();
+
+		for (std::uint32_t proxy = 0; proxy < bounds.size(); ++proxy)
+		{
+			const CellRange range = GetRange(bounds[proxy]);
+			for (std::int32_t y = range.MinY; y <= range.MaxY; ++y)
+			{
+				for (std::int32_t x = range.MinX; x <= range.MaxX; ++x)
+				{
+					m_cells.push_back({ x, y, proxy });
+				}
+			}
+		}
+
+		// Twice as many buckets as entries keeps collisions between cells rare
+		const size_t bucketCount = std::bit_ceil(std::max<size_t>(m_cells.size() * 2, 16));
+		m_bucketMask = static_cast<std::uint32_t>(bucketCount - 1);
+
+		m_bucketStart.assign(bucketCount + 1, 0);
+		for (CellEntry const& entry : m_cells)
+		{
+			m_bucketStart[Bucket(entry.X, entry.Y) + 1]++;
+		}
+
+		for (size_t bucket = 0; bucket < bucketCount; ++bucket)
+		{
+			m_bucketStart[bucket + 1] += m_bucketStart[bucket];
+		}
+
+		m_entries.resize(m_cells.size());
+		m_cursor.assign(m_bucketStart.begin(), m_bucketStart.end() - 1);
+		for (CellEntry const& entry : m_cells)
+		{
+			m_entries[m_cursor[Bucket(entry.X, entry.Y)]++] = entry;
+		}
+	}
+
+	// Appends every pair of overlapping bounds once, sorted so the order matches a nested loop.
+	// bounds must be the span passed to Build.
+	void FindPairs(std::span<math::AABB const> bounds, std::vector<BroadphasePair>& pairs) const
+	{
+		const size_t firstPair = pairs.size();
+
+		for (size_t bucket = 0; bucket + 1 < m_bucketStart.size(); ++bucket)
+		{
+			const std::uint32_t begin = m_bucketStart[bucket];
+			const std::uint32_t end = m_bucketStart[bucket + 1];
+
+			for (std::uint32_t i = begin; i < end; ++i)
+			{
+				CellEntry const& a = m_entries[i];
+
+				for (std::uint32_t j = i + 1; j < end; ++j)
+				{
+					CellEntry const& b = m_entries[j];
+
+					// Different cells that hash to the same bucket
+					if (a.X != b.X || a.Y != b.Y)
+					{
+						continue;
+					}
+
+					math::AABB const& boundsA = bounds[a.Proxy];
+					math::AABB const& boundsB = bounds[b.Proxy];
+					if (!boundsA.Intersects(boundsB))
+					{
+						continue;
+					}
+
+					// Boxes sharing several cells are reported only by the one holding the
+					// minimum corner of their intersection
+					const math::Vector2 corner = {
+						std::max(boundsA.Min.X, boundsB.Min.X),
+						std::max(boundsA.Min.Y, boundsB.Min.Y)
+					};
+					if (ToCell(corner.X) != a.X || ToCell(corner.Y) != a.Y)
+					{
+						continue;
+					}
+
+					pairs.push_back({ std::min(a.Proxy, b.Proxy), std::max(a.Proxy, b.Proxy) });
+				}
+			}
+		}
+
+		std::sort(pairs.begin() + firstPair, pairs.end(), [](BroadphasePair const& lhs, BroadphasePair const& rhs) {
+			return lhs.Key() < rhs.Key();
+		});
+	}
+
+private:
+	struct CellEntry
+	{
+		std::int32_t X;
+		std::int32_t Y;
+		std::uint32_t Proxy;
+	};
+
+	struct CellRange
+	{
+		std::int32_t MinX;
+		std::int32_t MinY;
+		std::int32_t MaxX;
+		std::int32_t MaxY;
+	};
+
+	std::int32_t ToCell(float value) const
+	{
+		return static_cast<std::int32_t>(std::floor(value * m_inverseCellSize));
+	}
+
+	CellRange GetRange(math::AABB const& bounds) const
+	{
+		return { ToCell(bounds.Min.X), ToCell(bounds.Min.Y), ToCell(bounds.Max.X), ToCell(bounds.Max.Y) };
+	}
+
+	std::uint32_t Bucket(std::int32_t x, std::int32_t y) const
+	{
+		const auto hash = static_cast<std::uint32_t>(x) * 73856093u ^ static_cast<std::uint32_t>(y) * 19349663u;
+		return hash & m_bucketMask;
+	}
+
+	float m_cellSize = 0.f;
+	float m_inverseCellSize = 0.f;
+
+	std::uint32_t m_bucketMask = 0;
+	std::vector<std::uint32_t> m_bucketStart;
+	std::vector<std::uint32_t> m_cursor;
+	std::vector<CellEntry> m_cells;
+	std::vector<CellEntry> m_entries;
+
+	std::vector<BroadphasePair> m_pairs;
+	details::PairDiff m_diff;
+};
+
+} // namespace Engine::physics
@@ -0,0 +1,407 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+#include "../ECS/Entity/Entity.h"
+#include "../Math/AABBBatch.h"
+#include "../Math/Vector2.h"
+
+#include "Broadphase.h"
+
+namespace Engine::physics
+{
+
+// Keeps the bound endpoints of every proxy sorted on both axes. Bodies move a little per step, so
+// an insertion sort restores the order in close to linear time, and every swap of a minimum with
+// a maximum is exactly a pair starting or stopping to overlap on that axis.
+class SweepAndPrune final : public IBroadphase
+{
+public:
+	void Update(std::span<ecs::Entity const> entities, std::span<math::AABB const> bounds, std::span<BodyKind const>) override
+	{
+		m_added.clear();
+		m_removed.clear();
+		m_stamp++;
+
+		SyncProxies(entities, bounds);
+		RemoveStaleProxies();
+
+		// A sort from scratch beats inserting many endpoints one by one, e.g. on the first step
+		if (m_pending.size() > RebuildThreshold + m_proxyCount / 4)
+		{
+			AddPendingProxies(false);
+			Rebuild();
+		}
+		else
+		{
+			AddPendingProxies(true);
+			for (size_t axis = 0; axis < m_axes.size(); ++axis)
+			{
+				InsertionSort(axis);
+			}
+		}
+
+		CollectPairs();
+	}
+
+	std::span<BroadphasePair const> GetPairs() const override
+	{
+		return m_pairs;
+	}
+
+	std::span<EntityPair const> GetAddedPairs() const override
+	{
+		return m_added;
+	}
+
+	std::span<EntityPair const> GetRemovedPairs() const override
+	{
+		return m_removed;
+	}
+
+	std::shared_ptr<IBroadphase> Clone() const override
+	{
+		return std::make_shared<SweepAndPrune>(*this);
+	}
+
+private:
+	static constexpr std::uint32_t NoProxy = std::numeric_limits<std::uint32_t>::max();
+	static constexpr size_t RebuildThreshold = 64;
+
+	struct Proxy
+	{
+		ecs::Entity Entity = ecs::InvalidEntity;
+		math::AABB Bounds;
+		// Position in the spans of the current update
+		std::uint32_t Index = 0;
+		std::uint32_t Stamp = 0;
+	};
+
+	// Proxy index shifted left by one, the low bit marks a maximum
+	struct Endpoint
+	{
+		float Value;
+		std::uint32_t Data;
+
+		std::uint32_t Proxy() const { return Data >> 1; }
+		bool IsMax() const { return Data & 1; }
+	};
+
+	struct PendingProxy
+	{
+		ecs::Entity Entity;
+		std::uint32_t Index;
+	};
+
+	static float GetMin(math::AABB const& bounds, size_t axis) { return axis == 0 ? bounds.Min.X : bounds.Min.Y; }
+	static float GetMax(math::AABB const& bounds, size_t axis) { return axis == 0 ? bounds.Max.X : bounds.Max.Y; }
+
+	// Touching bounds overlap, so a minimum sorts before a maximum of the same value
+	static bool Less(Endpoint const& lhs, Endpoint const& rhs)
+	{
+		return lhs.Value < rhs.Value || (lhs.Value == rhs.Value && !lhs.IsMax() && rhs.IsMax());
+	}
+
+	static std::uint64_t PairKey(std::uint32_t a, std::uint32_t b)
+	{
+		return a < b ? (static_cast<std::uint64_t>(a) << 32) | b : (static_cast<std::uint64_t>(b) << 32) | a;
+	}
+
+	void SyncProxies(std::span<ecs::Entity const> entities, std::span<math::AABB const> bounds)
+	{
+		m_pending.clear();
+
+		for (std::uint32_t i = 0; i < entities.size(); ++i)
+		{
+			const ecs::Entity entity = entities[i];
+			const size_t index = entity.Index();
+
+			if (index >= m_proxyOfEntity.size())
+			{
+				m_proxyOfEntity.resize(index + 1, NoProxy);
+			}
+
+			const std::uint32_t proxy = m_proxyOfEntity[index];
+			if (proxy == NoProxy || m_proxies[proxy].Entity != entity)
+			{
+				m_pending.push_back({ entity, i });
+				continue;
+			}
+
+			m_proxies[proxy].Bounds = bounds[i];
+			m_proxies[proxy].Index = i;
+			m_proxies[proxy].Stamp = m_stamp;
+		}
+
+		for (PendingProxy const& pending : m_pending)
+		{
+			m_pendingBounds.push_back(bounds[pending.Index]);
+		}
+	}
+
+	void RemoveStaleProxies()
+	{
+		bool anyStale = false;
+		for (Proxy const& proxy : m_proxies)
+		{
+			anyStale |= proxy.Entity != ecs::InvalidEntity && proxy.Stamp != m_stamp;
+		}
+
+		if (!anyStale)
+		{
+			return;
+		}
+
+		auto isStale = [this](std::uint32_t proxy) {
+			return m_proxies[proxy].Stamp != m_stamp;
+		};
+
+		for (auto it = m_pairSet.begin(); it != m_pairSet.end();)
+		{
+			const auto first = static_cast<std::uint32_t>(*it >> 32);
+			const auto second = static_cast<std::uint32_t>(*it);
+
+			if (isStale(first) || isStale(second))
+			{
+				m_removed.push_back(EntityPair::Make(m_proxies[first].Entity, m_proxies[second].Entity));
+				it = m_pairSet.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		for (auto& axis : m_axes)
+		{
+			std::erase_if(axis, [&](Endpoint const& endpoint) {
+				return isStale(endpoint.Proxy());
+			});
+		}
+
+		for (std::uint32_t proxy = 0; proxy < m_proxies.size(); ++proxy)
+		{
+			Proxy& stale = m_proxies[proxy];
+			if (stale.Entity == ecs::InvalidEntity || stale.Stamp == m_stamp)
+			{
+				continue;
+			}
+
+			if (m_proxyOfEntity[stale.Entity.Index()] == proxy)
+			{
+				m_proxyOfEntity[stale.Entity.Index()] = NoProxy;
+			}
+
+			stale.Entity = ecs::InvalidEntity;
+			m_freeProxies.push_back(proxy);
+			m_proxyCount--;
+		}
+	}
+
+	void AddPendingProxies(bool appendEndpoints)
+	{
+		for (size_t i = 0; i < m_pending.size(); ++i)
+		{
+			std::uint32_t proxy;
+			if (!m_freeProxies.empty())
+			{
+				proxy = m_freeProxies.back();
+				m_freeProxies.pop_back();
+			}
+			else
+			{
+				proxy = static_cast<std::uint32_t>(m_proxies.size());
+				m_proxies.emplace_back();
+			}
+
+			m_proxies[proxy] = { m_pending[i].Entity, m_pendingBounds[i], m_pending[i].Index, m_stamp };
+			m_proxyOfEntity[m_pending[i].Entity.Index()] = proxy;
+			m_proxyCount++;
+
+			// Appended endpoints act as if the proxy came from beyond every other one, the
+			// insertion sort then reports each overlap while moving them into place
+			if (appendEndpoints)
+			{
+				for (size_t axis = 0; axis < m_axes.size(); ++axis)
+				{
+					m_axes[axis].push_back({ GetMin(m_pendingBounds[i], axis), proxy << 1 });
+					m_axes[axis].push_back({ GetMax(m_pendingBounds[i], axis), (proxy << 1) | 1 });
+				}
+			}
+		}
+
+		m_pendingBounds.clear();
+	}
+
+	void InsertionSort(size_t axisIndex)
+	{
+		std::vector<Endpoint>& axis = m_axes[axisIndex];
+
+		for (Endpoint& endpoint : axis)
+		{
+			math::AABB const& bounds = m_proxies[endpoint.Proxy()].Bounds;
+			endpoint.Value = endpoint.IsMax() ? GetMax(bounds, axisIndex) : GetMin(bounds, axisIndex);
+		}
+
+		for (size_t i = 1; i < axis.size(); ++i)
+		{
+			const Endpoint endpoint = axis[i];
+			math::AABB const& bounds = m_proxies[endpoint.Proxy()].Bounds;
+
+			size_t j = i;
+			while (j > 0 && Less(endpoint, axis[j - 1]))
+			{
+				Endpoint const& previous = axis[j - 1];
+
+				if (!endpoint.IsMax() && previous.IsMax())
+				{
+					// Started overlapping on this axis, the pair exists if the other axis agrees
+					if (bounds.Intersects(m_proxies[previous.Proxy()].Bounds))
+					{
+						AddPair(endpoint.Proxy(), previous.Proxy());
+					}
+				}
+				else if (endpoint.IsMax() && !previous.IsMax())
+				{
+					RemovePair(endpoint.Proxy(), previous.Proxy());
+				}
+
+				axis[j] = previous;
+				--j;
+			}
+
+			axis[j] = endpoint;
+		}
+	}
+
+	void Rebuild()
+	{
+		std::unordered_set<std::uint64_t> previous;
+		std::swap(previous, m_pairSet);
+
+		for (size_t axis = 0; axis < m_axes.size(); ++axis)
+		{
+			m_axes[axis].clear();
+			for (std::uint32_t proxy = 0; proxy < m_proxies.size(); ++proxy)
+			{
+				if (m_proxies[proxy].Entity != ecs::InvalidEntity)
+				{
+					m_axes[axis].push_back({ GetMin(m_proxies[proxy].Bounds, axis), proxy << 1 });
+					m_axes[axis].push_back({ GetMax(m_proxies[proxy].Bounds, axis), (proxy << 1) | 1 });
+				}
+			}
+			std::sort(m_axes[axis].begin(), m_axes[axis].end(), Less);
+		}
+
+		// Sweep along x keeping the proxies whose interval is open, their bounds mirrored in a batch
+		m_active.clear();
+		m_activeBounds.Clear();
+		m_activePosition.resize(m_proxies.size());
+		for (Endpoint const& endpoint : m_axes[0])
+		{
+			const std::uint32_t proxy = endpoint.Proxy();
+
+			if (endpoint.IsMax())
+			{
+				const std::uint32_t position = m_activePosition[proxy];
+				m_active[position] = m_active.back();
+				m_activePosition[m_active[position]] = position;
+				m_active.pop_back();
+				m_activeBounds.RemoveSwap(position);
+				continue;
+			}
+
+			math::AABB const& bounds = m_proxies[proxy].Bounds;
+			m_activeBounds.ForEachOverlap(bounds, 0, m_active.size(), [&](size_t position) {
+				m_pairSet.insert(PairKey(proxy, m_active[position]));
+			});
+
+			m_activePosition[proxy] = static_cast<std::uint32_t>(m_active.size());
+			m_active.push_back(proxy);
+			m_activeBounds.Add(bounds);
+		}
+
+		auto toEntities = [this](std::uint64_t key) {
+			return EntityPair::Make(m_proxies[static_cast<std::uint32_t>(key >> 32)].Entity,
+				m_proxies[static_cast<std::uint32_t>(key)].Entity);
+		};
+
+		for (std::uint64_t key : m_pairSet)
+		{
+			if (!previous.contains(key))
+			{
+				m_added.push_back(toEntities(key));
+			}
+		}
+
+		for (std::uint64_t key : previous)
+		{
+			if (!m_pairSet.contains(key))
+			{
+				m_removed.push_back(toEntities(key));
+			}
+		}
+	}
+
+	void AddPair(std::uint32_t a, std::uint32_t b)
+	{
+		if (m_pairSet.insert(PairKey(a, b)).second)
+		{
+			m_added.push_back(EntityPair::Make(m_proxies[a].Entity, m_proxies[b].Entity));
+		}
+	}
+
+	void RemovePair(std::uint32_t a, std::uint32_t b)
+	{
+		if (m_pairSet.erase(PairKey(a, b)) > 0)
+		{
+			m_removed.push_back(EntityPair::Make(m_proxies[a].Entity, m_proxies[b].Entity));
+		}
+	}
+
+	void CollectPairs()
+	{
+		m_pairs.clear();
+		m_pairs.reserve(m_pairSet.size());
+
+		for (std::uint64_t key : m_pairSet)
+		{
+			const std::uint32_t first = m_proxies[static_cast<std::uint32_t>(key >> 32)].Index;
+			const std::uint32_t second = m_proxies[static_cast<std::uint32_t>(key)].Index;
+			m_pairs.push_back({ std::min(first, second), std::max(first, second) });
+		}
+
+		std::sort(m_pairs.begin(), m_pairs.end(), [](BroadphasePair const& lhs, BroadphasePair const& rhs) {
+			return lhs.Key() < rhs.Key();
+		});
+	}
+
+	std::vector<Proxy> m_proxies;
+	std::vector<std::uint32_t> m_freeProxies;
+	size_t m_proxyCount = 0;
+	std::uint32_t m_stamp = 0;
+
+	// Indexed by entity index
+	std::vector<std::uint32_t> m_proxyOfEntity;
+
+	std::array<std::vector<Endpoint>, 2> m_axes;
+	std::unordered_set<std::uint64_t> m_pairSet;
+
+	std::vector<PendingProxy> m_pending;
+	std::vector<math::AABB> m_pendingBounds;
+	std::vector<std::uint32_t> m_active;
+	math::AABBBatch m_activeBounds;
+	std::vector<std::uint32_t> m_activePosition;
+
+	std::vector<BroadphasePair> m_pairs;
+	std::vector<EntityPair> m_added;
+	std::vector<EntityPair> m_removed;
+};
+
+} // namespace Engine::physics
@@ -1,127 +1,881 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <span>
+#include <vector>
+
 #include "../ECS/Scene/Scene.h"
 #include "../ECS/System/System.h"
+#include "../Math/AABBBatch.h"
 
+#include "Broadphase.h"
 #include "Components.h"
+#include "ContactCache.h"
+#include "Islands.h"
+#include "Query.h"
+#include "SleepingBodies.h"
+#include "SpatialHash.h"
+#include "SweepAndPrune.h"
+#include "TreeBroadphase.h"
 
 namespace Engine::physics
 {
 
+// Each scene's PhysicsSystem has its own settings, passed to RegisterSystem or SetSettings
+struct PhysicsSettings
+{
+	// The AABB tree also answers physics::Query, with other broadphases queries test every collider
+	BroadphaseKind Broadphase = BroadphaseKind::AABBTree;
+	// Spatial hash cell, about the size of a typical collider
+	float CellSize = 100.f;
+	// AABB tree leaves are grown by this much, smaller moves don't touch the tree
+	float TreeMargin = 10.f;
+	// Velocity passes over the contacts of an island per step
+	int SolverIterations = 4;
+	// Starts each contact from the impulse it ended the last step with, stacks then settle
+	// with few iterations
+	bool WarmStarting = true;
+	// Islands whose bodies all stay below SleepVelocity for SleepFrames steps stop being simulated
+	// until an awake body touches them or gameplay edits one of them and calls MarkChanged
+	bool AllowSleeping = true;
+	float SleepVelocity = 1.f;
+	int SleepFrames = 30;
+};
+
 class PhysicsSystem : public ecs::System
 {
 public:
+	explicit PhysicsSystem(PhysicsSettings settings = {})
+	{
+		SetSettings(settings);
+	}
+
+	// Switching the broadphase starts the new one empty, its first step reports every pair as added
+	void SetSettings(PhysicsSettings const& settings)
+	{
+		m_settings = settings;
+		m_broadphase = CreateBroadphase(settings);
+		m_tree = std::dynamic_pointer_cast<TreeBroadphase>(m_broadphase);
+		m_colliders = m_tree ? nullptr : std::make_shared<BoundsList>();
+
+		if (!settings.AllowSleeping)
+		{
+			for (auto const& [island, members] : m_islandMembers)
+			{
+				m_wakeIslands.push_back(island);
+			}
+			// The map's order isn't kept by copies, the order islands wake in is
+			std::ranges::sort(m_wakeIslands);
+		}
+	}
+
+	// Keeps the broadphase pairs, contact cache and sleeping islands, so a cloned scene steps
+	// the same as its source
+	std::unique_ptr<ecs::System> Clone() const override
+	{
+		auto clone = std::make_unique<PhysicsSystem>(*this);
+		clone->m_broadphase = m_broadphase->Clone();
+		clone->m_sleeping = std::make_shared<SleepingBodies>(*m_sleeping);
+		clone->m_tree = std::dynamic_pointer_cast<TreeBroadphase>(clone->m_broadphase);
+		clone->m_colliders = m_colliders ? std::make_shared<BoundsList>(*m_colliders) : nullptr;
+		return clone;
+	}
+
 	void Update(ecs::Scene& scene, float dt) override
 	{
 		using namespace math;
 		using namespace physics::components;
 
-		for (auto& entity : Entities)
+		m_entities.clear();
+		m_changed.clear();
+		m_bounds.clear();
+		m_kinds.clear();
+		m_broadphaseKinds.clear();
+		m_bodies.clear();
+		m_filters.clear();
+		m_bullets.clear();
+		m_sensors.clear();
+		m_entities.reserve(m_active.size());
+		m_bounds.reserve(m_active.size());
+		m_kinds.reserve(m_active.size());
+		m_broadphaseKinds.reserve(m_active.size());
+		m_bodies.reserve(m_active.size());
+		m_filters.reserve(m_active.size());
+
+		WakeIslands(scene);
+
+		// Sleeping bodies wait in m_sleeping until an awake one touches them. Sleeping sensors
+		// stay in the step as static bodies so they keep reporting overlaps.
+		for (ecs::Entity entity : m_active)
 		{
-			auto& transform = entity.GetComponent<Transform>();
-			auto& rigidBody = entity.GetComponent<RigidBody>();
-			auto& collider = entity.GetComponent<AABBCollider>();
+			auto& transform = scene.GetComponent<Transform>(entity);
+			auto& rigidBody = scene.GetComponent<RigidBody>(entity);
+			auto& collider = scene.GetComponent<AABBCollider>(entity);
 
-			rigidBody.Velocity *= (1.0f - dt * rigidBody.LinearDamping);
+			const bool sleeping = GetSleepState(entity).Island != NoIsland;
+			// Asleep without an island, as when loaded or copied from another scene
+			if (rigidBody.Sleeping && !sleeping)
+			{
+				rigidBody.Sleeping = false;
+				m_changed.push_back(entity);
+			}
+
+			if (!sleeping)
+			{
+				rigidBody.Velocity *= (1.0f - dt * rigidBody.LinearDamping);
 
-			transform.Position += rigidBody.Velocity * dt;
+				if (rigidBody.ContinuousCollision && rigidBody.InvertedMass() > 0.f)
+				{
+					m_bullets.push_back({ static_cast<std::uint32_t>(m_bodies.size()), transform.Position });
+				}
+
+				transform.Position += rigidBody.Velocity * dt;
+			}
 			collider.MoveBounds(transform.Position);
+
+			AddBody(entity, transform.Position, rigidBody, collider, sleeping);
 		}
 
-		std::vector<CollisionManifold> collisions;
-		for (size_t i = 0; i < Entities.size(); ++i)
+		SweepBullets();
+
+		if (m_settings.AllowSleeping)
 		{
-			for (size_t j = i + 1; j < Entities.size(); ++j)
+			WakeTouchedIslands(scene);
+		}
+
+		m_broadphase->Update(m_entities, m_bounds, m_broadphaseKinds);
+
+		if (scene.HasResource<Query>())
+		{
+			if (m_colliders)
 			{
-				auto& entityA = Entities[i];
-				auto& entityB = Entities[j];
+				m_colliders->Assign(m_entities, m_bounds);
+			}
 
-				const auto& colliderA = entityA.GetComponent<AABBCollider>();
-				const auto& colliderB = entityB.GetComponent<AABBCollider>();
+			Query& query = scene.GetResource<Query>();
+			query.m_broadphase = m_tree;
+			query.m_colliders = m_colliders;
+			query.m_sleeping = m_sleeping;
+		}
 
-				if (colliderA.Bounds.Intersects(colliderB.Bounds))
-				{
-					collisions.emplace_back(CreateManifold(entityA, entityB));
-				}
+		FilterPairs(m_broadphase->GetPairs());
+
+		// Narrowphase, every pair writes its own slot
+		std::span<BroadphasePair const> pairs = m_solvePairs;
+		m_contacts.resize(pairs.size());
+		scene.ParallelFor(pairs.size(), PairsPerTask, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; ++i)
+			{
+				m_contacts[i] = CreateContact(pairs[i].First, pairs[i].Second);
+			}
+		});
+
+		// Islands share no dynamic body, each is solved in pair order on one thread, so the result
+		// is the same for any thread count
+		m_islands.Build(m_bodies.size(), pairs, m_kinds);
+		scene.ParallelFor(m_islands.GetIslandCount(), IslandsPerTask, [&](size_t begin, size_t end) {
+			for (size_t island = begin; island < end; ++island)
+			{
+				SolveIsland(m_islands.GetContacts(island));
+			}
+		});
+
+		m_cacheEntries.clear();
+		for (Contact const& contact : m_contacts)
+		{
+			if (contact.NormalImpulse > 0.f)
+			{
+				auto [pair, normal] = GetCacheKey(contact);
+				m_cacheEntries.push_back({ pair, normal, contact.NormalImpulse });
 			}
 		}
+		m_contactCache.Assign(m_cacheEntries);
+
+		for (std::uint32_t body = 0; body < m_bodies.size(); ++body)
+		{
+			if (m_kinds[body] == BodyKind::Dynamic)
+			{
+				scene.GetComponent<Transform>(m_entities[body]).Position = m_bodies[body].Position;
+				scene.GetComponent<RigidBody>(m_entities[body]).Velocity = m_bodies[body].Velocity;
+				m_changed.push_back(m_entities[body]);
+			}
+			// Static bodies with a velocity were moved by the integration
+			else if (m_bodies[body].Velocity != Vector2{})
+			{
+				m_changed.push_back(m_entities[body]);
+			}
+		}
+
+		if (m_settings.AllowSleeping)
+		{
+			SleepIslands(scene);
+		}
+
+		// Indices and the frame history only see marked writes. The bodies that fell asleep are
+		// among them, so this system ignores its own marks.
+		m_marking = true;
+		scene.MarkChanged<Transform>(m_changed);
+		scene.MarkChanged<RigidBody>(m_changed);
+		m_marking = false;
+	}
+
+	void OnEntityAdded(ecs::Entity entity) override
+	{
+		Activate(GetSleepState(entity));
+	}
+
+	// The rest of the island wakes, it may have rested on the body
+	void OnEntityRemoved(ecs::Entity entity) override
+	{
+		SleepState& state = GetSleepState(entity);
+		if (state.ActiveSlot != NotActive)
+		{
+			Deactivate(state);
+		}
 
-		for (const auto& manifold : collisions)
+		if (state.Island != NoIsland)
 		{
-			ResolveCollision(scene, manifold);
+			m_wakeIslands.push_back(state.Island);
+			if (!state.CollisionFilter.Sensor)
+			{
+				m_sleeping->Remove(entity);
+			}
 		}
+
+		state = SleepState{};
+	}
+
+	void OnComponentChanged(ecs::Entity entity, ecs::TypeIndexType componentType) override
+	{
+		if (m_marking || entity.Index() >= m_sleepStates.size())
+		{
+			return;
+		}
+
+		SleepState const& state = m_sleepStates[entity.Index()];
+		if (state.Entity == entity && state.Island != NoIsland)
+		{
+			m_wakeIslands.push_back(state.Island);
+		}
+	}
+
+	PhysicsSettings const& GetSettings() const
+	{
+		return m_settings;
+	}
+
+	// Collider pairs whose bounds began or stopped overlapping in the last step, before layers,
+	// masks and sensors are applied. Sleeping bodies aren't in the broadphase, their pairs end
+	// when they fall asleep.
+	std::span<EntityPair const> GetAddedPairs() const
+	{
+		return m_broadphase->GetAddedPairs();
+	}
+
+	std::span<EntityPair const> GetRemovedPairs() const
+	{
+		return m_broadphase->GetRemovedPairs();
+	}
+
+	// Pairs with a sensor that began or stopped overlapping in the last step, among colliders
+	// whose layers and masks match and that aren't both static
+	std::span<EntityPair const> GetSensorAddedPairs() const
+	{
+		return m_sensorPairs.GetAdded();
+	}
+
+	std::span<EntityPair const> GetSensorRemovedPairs() const
+	{
+		return m_sensorPairs.GetRemoved();
 	}
 
 private:
-	components::CollisionManifold CreateManifold(
-		ecs::System::WrappedEntity const& entityA,
-		ecs::System::WrappedEntity const& entityB)
+	static constexpr size_t PairsPerTask = 256;
+	static constexpr size_t IslandsPerTask = 16;
+
+	// State of body i during a step, solved without touching the component pools
+	struct Body
+	{
+		math::Vector2 Position;
+		math::Vector2 Velocity;
+		math::Vector2 Size;
+		float InvMass;
+		float Restitution;
+	};
+
+	// Collider settings of body i, Static for bodies without mass, not for sleeping ones
+	struct Filter
+	{
+		std::uint32_t Layer;
+		std::uint32_t Mask;
+		bool Sensor;
+		bool Static;
+	};
+
+	static bool ShouldCollide(Filter const& a, Filter const& b)
+	{
+		return (a.Layer & b.Mask) != 0 && (b.Layer & a.Mask) != 0;
+	}
+
+	// Sorts broadphase pairs before the narrowphase: pairs the layers or masks filter out and
+	// pairs of two static bodies are dropped, sensor pairs only feed the sensor events, and of
+	// the rest the pairs with an awake dynamic body go to the solver. Sensors also overlap the
+	// sleeping bodies, which the broadphase doesn't hold.
+	void FilterPairs(std::span<BroadphasePair const> pairs)
+	{
+		m_solvePairs.clear();
+		m_sensorCandidates.clear();
+
+		for (BroadphasePair const& pair : pairs)
+		{
+			Filter const& first = m_filters[pair.First];
+			Filter const& second = m_filters[pair.Second];
+			if (!ShouldCollide(first, second) || (first.Static && second.Static))
+			{
+				continue;
+			}
+
+			if (first.Sensor || second.Sensor)
+			{
+				m_sensorCandidates.push_back(EntityPair::Make(m_entities[pair.First], m_entities[pair.Second]));
+			}
+			else if (m_kinds[pair.First] == BodyKind::Dynamic || m_kinds[pair.Second] == BodyKind::Dynamic)
+			{
+				m_solvePairs.push_back(pair);
+			}
+		}
+
+		for (std::uint32_t sensor : m_sensors)
+		{
+			m_sleeping->GetTree().Query(m_bounds[sensor], [&](std::uint32_t proxy) {
+				const ecs::Entity entity = m_sleeping->GetEntity(proxy);
+				if (m_sleeping->GetBounds(proxy).Intersects(m_bounds[sensor]) && ShouldCollide(m_filters[sensor], GetSleepState(entity).CollisionFilter))
+				{
+					m_sensorCandidates.push_back(EntityPair::Make(m_entities[sensor], entity));
+				}
+				return true;
+			});
+		}
+
+		m_sensorPairs.Update(m_sensorCandidates);
+	}
+
+	// Appends the entity to the bodies of this step, a sleeping sensor takes part as a static body
+	void AddBody(ecs::Entity entity, math::Vector2 const& position, components::RigidBody const& rigidBody, components::AABBCollider const& collider, bool sleeping)
+	{
+		const bool isStatic = rigidBody.InvertedMass() == 0.f;
+		const BodyKind kind = sleeping || isStatic ? BodyKind::Static : BodyKind::Dynamic;
+
+		if (collider.Sensor)
+		{
+			m_sensors.push_back(static_cast<std::uint32_t>(m_bodies.size()));
+		}
+
+		m_entities.push_back(entity);
+		m_bounds.push_back(collider.Bounds);
+		m_kinds.push_back(kind);
+		// Sensors go in as dynamic so the broadphase still pairs them with static bodies
+		m_broadphaseKinds.push_back(collider.Sensor ? BodyKind::Dynamic : kind);
+		m_bodies.push_back({ position, sleeping ? math::Vector2{} : rigidBody.Velocity, collider.Size, sleeping ? 0.f : rigidBody.InvertedMass(), rigidBody.Restitution });
+		m_filters.push_back({ collider.Layer, collider.Mask, collider.Sensor, isStatic });
+	}
+
+	// Below this approach speed contacts don't bounce, resting bodies would jitter otherwise
+	static constexpr float RestitutionThreshold = 1.f;
+
+	// Indices into m_bodies, Normal points from B towards A
+	struct Contact
+	{
+		std::uint32_t BodyA = 0;
+		std::uint32_t BodyB = 0;
+		math::Vector2 Normal;
+		float Penetration = 0.f;
+		// Accumulated over the iterations, starts from the cache
+		float NormalImpulse = 0.f;
+		float NormalMass = 0.f;
+		// Normal velocity the solver aims for, the bounce
+		float TargetVelocity = 0.f;
+	};
+
+	static std::shared_ptr<IBroadphase> CreateBroadphase(PhysicsSettings const& settings)
+	{
+		switch (settings.Broadphase)
+		{
+		case BroadphaseKind::BruteForce:
+			return std::make_shared<BruteForceBroadphase>();
+		case BroadphaseKind::SpatialHash:
+			return std::make_shared<SpatialHash>(settings.CellSize);
+		case BroadphaseKind::SweepAndPrune:
+			return std::make_shared<SweepAndPrune>();
+		case BroadphaseKind::AABBTree:
+		default:
+			return std::make_shared<TreeBroadphase>(settings.TreeMargin);
+		}
+	}
+
+	Contact CreateContact(std::uint32_t bodyA, std::uint32_t bodyB) const
 	{
 		using namespace math;
-		using namespace physics::components;
 
-		const auto& trA = entityA.GetComponent<Transform>();
-		const auto& trB = entityB.GetComponent<Transform>();
-		const auto& colA = entityA.GetComponent<AABBCollider>();
-		const auto& colB = entityB.GetComponent<AABBCollider>();
+		Body const& a = m_bodies[bodyA];
+		Body const& b = m_bodies[bodyB];
 
-		Vector2 n = trB.Position - trA.Position;
-		float x_overlap = (colA.Size.X / 2.f) + (colB.Size.X / 2.f) - std::abs(n.X);
-		float y_overlap = (colA.Size.Y / 2.f) + (colB.Size.Y / 2.f) - std::abs(n.Y);
+		Vector2 n = b.Position - a.Position;
+		float x_overlap = (a.Size.X / 2.f) + (b.Size.X / 2.f) - std::abs(n.X);
+		float y_overlap = (a.Size.Y / 2.f) + (b.Size.Y / 2.f) - std::abs(n.Y);
 
-		CollisionManifold manifold;
-		manifold.EntityA = entityA.GetEntity();
-		manifold.EntityB = entityB.GetEntity();
+		Contact contact;
+		contact.BodyA = bodyA;
+		contact.BodyB = bodyB;
 
 		if (x_overlap < y_overlap)
 		{
-			manifold.Penetration = x_overlap;
-			manifold.Normal = (n.X > 0) ? Vector2{ -1.0f, 0.0f } : Vector2{ 1.0f, 0.0f };
+			contact.Penetration = x_overlap;
+			contact.Normal = (n.X > 0) ? Vector2{ -1.0f, 0.0f } : Vector2{ 1.0f, 0.0f };
 		}
 		else
 		{
-			manifold.Penetration = y_overlap;
-			manifold.Normal = (n.Y > 0) ? Vector2{ 0.0f, -1.0f } : Vector2{ 0.0f, 1.0f };
+			contact.Penetration = y_overlap;
+			contact.Normal = (n.Y > 0) ? Vector2{ 0.0f, -1.0f } : Vector2{ 0.0f, 1.0f };
 		}
-		return manifold;
+
+		auto [pair, normal] = GetCacheKey(contact);
+		contact.NormalImpulse = m_contactCache.Find(pair, normal);
+		return contact;
+	}
+
+	// The cache keys contacts by entity pair, with the normal turned to run from First to Second
+	std::pair<EntityPair, math::Vector2> GetCacheKey(Contact const& contact) const
+	{
+		const ecs::Entity entityA = m_entities[contact.BodyA];
+		const ecs::Entity entityB = m_entities[contact.BodyB];
+		const EntityPair pair = EntityPair::Make(entityA, entityB);
+
+		return { pair, pair.First == entityB ? contact.Normal : contact.Normal * -1.f };
 	}
 
-	void ResolveCollision(ecs::Scene& world, components::CollisionManifold const& manifold)
+	// Sequential impulses: each pass applies the impulse that brings one contact to its target
+	// normal velocity, clamping the accumulated impulse so contacts only push
+	void SolveIsland(std::span<std::uint32_t const> contacts)
 	{
 		using namespace math;
-		using namespace physics::components;
 
-		auto& rbA = world.GetComponent<RigidBody>(manifold.EntityA);
-		auto& rbB = world.GetComponent<RigidBody>(manifold.EntityB);
-		auto& trA = world.GetComponent<Transform>(manifold.EntityA);
-		auto& trB = world.GetComponent<Transform>(manifold.EntityB);
+		for (std::uint32_t index : contacts)
+		{
+			Contact& contact = m_contacts[index];
+			Body const& a = m_bodies[contact.BodyA];
+			Body const& b = m_bodies[contact.BodyB];
 
-		float invMassA = rbA.InvertedMass();
-		float invMassB = rbB.InvertedMass();
+			const float inverseMass = a.InvMass + b.InvMass;
+			contact.NormalMass = inverseMass > 0.f ? 1.f / inverseMass : 0.f;
 
-		Vector2 rv = rbB.Velocity - rbA.Velocity;
-		float velAlongNormal = Dot(rv, manifold.Normal);
+			const float normalVelocity = Dot(a.Velocity - b.Velocity, contact.Normal);
+			const float restitution = std::min(a.Restitution, b.Restitution);
+			contact.TargetVelocity = normalVelocity < -RestitutionThreshold ? -restitution * normalVelocity : 0.f;
 
-		if (velAlongNormal > 0)
-			return;
+			if (!m_settings.WarmStarting)
+			{
+				contact.NormalImpulse = 0.f;
+			}
+		}
+
+		for (std::uint32_t index : contacts)
+		{
+			ApplyImpulse(m_contacts[index], m_contacts[index].NormalImpulse);
+		}
 
-		float e = std::min(rbA.Restitution, rbB.Restitution);
-		float j = -(1 + e) * velAlongNormal;
-		j /= invMassA + invMassB;
+		for (int iteration = 0; iteration < m_settings.SolverIterations; ++iteration)
+		{
+			for (std::uint32_t index : contacts)
+			{
+				Contact& contact = m_contacts[index];
 
-		Vector2 impulse = j * manifold.Normal;
+				const float normalVelocity = Dot(m_bodies[contact.BodyA].Velocity - m_bodies[contact.BodyB].Velocity, contact.Normal);
+				const float impulse = contact.NormalMass * (contact.TargetVelocity - normalVelocity);
 
-		rbA.Velocity += impulse * invMassA;
-		rbB.Velocity -= impulse * invMassB;
+				const float accumulated = std::max(contact.NormalImpulse + impulse, 0.f);
+				ApplyImpulse(contact, accumulated - contact.NormalImpulse);
+				contact.NormalImpulse = accumulated;
+			}
+		}
 
+		// Pushes out what penetration is left, the velocities no longer have to
 		const float percent = 0.2f;
 		const float slop = 0.01f;
-		Vector2 correction = std::max(manifold.Penetration - slop, 0.0f)
-			/ (invMassA + invMassB) * percent * manifold.Normal;
+		for (std::uint32_t index : contacts)
+		{
+			Contact const& contact = m_contacts[index];
+			Body& a = m_bodies[contact.BodyA];
+			Body& b = m_bodies[contact.BodyB];
 
-		trA.Position += correction * invMassA;
-		trB.Position -= correction * invMassB;
+			Vector2 correction = std::max(contact.Penetration - slop, 0.0f) * contact.NormalMass * percent * contact.Normal;
+			if (a.InvMass > 0.f)
+			{
+				a.Position += correction * a.InvMass;
+			}
+			if (b.InvMass > 0.f)
+			{
+				b.Position -= correction * b.InvMass;
+			}
+		}
 	}
+
+	// Body with ContinuousCollision and where it started the step
+	struct Bullet
+	{
+		std::uint32_t Body = 0;
+		math::Vector2 Start;
+	};
+
+	// A swept body stops this far inside what it hit, so the broadphase pairs the two this step.
+	// Below the solver slop, the contact isn't pushed apart.
+	static constexpr float SweepSkin = 0.005f;
+
+	// Moves bullets back to where they first touch a static or sleeping collider on the way from
+	// their start. Runs before the broadphase update against the static bounds of this step, so it
+	// works with any broadphase and sees colliders added this step; a sleeping body it stops at is
+	// then woken by the touch. Colliders the bullet already overlapped at the start are left to the
+	// narrowphase. Sensors and colliders the layers filter out don't stop it.
+	void SweepBullets()
+	{
+		using namespace math;
+
+		if (m_bullets.empty())
+		{
+			return;
+		}
+
+		m_staticBatch.Clear();
+		m_staticBodies.clear();
+		for (std::uint32_t body = 0; body < m_bodies.size(); ++body)
+		{
+			if (m_kinds[body] == BodyKind::Static && !m_filters[body].Sensor)
+			{
+				m_staticBatch.Add(m_bounds[body]);
+				m_staticBodies.push_back(body);
+			}
+		}
+
+		for (Bullet const& bullet : m_bullets)
+		{
+			Body& body = m_bodies[bullet.Body];
+			const Vector2 displacement = body.Position - bullet.Start;
+			if (displacement == Vector2{})
+			{
+				continue;
+			}
+
+			const Vector2 halfSize = body.Size * 0.5f;
+			const AABB startBounds = { bullet.Start - halfSize, bullet.Start + halfSize };
+			const AABB sweptBounds = Union(startBounds, m_bounds[bullet.Body]);
+
+			// Sweeping the box is casting its center against bounds grown by its half size
+			auto grow = [&](AABB const& bounds) {
+				return AABB{ bounds.Min - halfSize, bounds.Max + halfSize };
+			};
+
+			float fraction = 1.f;
+			Vector2 normal;
+			auto cast = [&](AABB const& bounds, Filter const& filter) {
+				if (!ShouldCollide(m_filters[bullet.Body], filter) || bounds.Intersects(startBounds))
+				{
+					return;
+				}
+
+				const float entry = AABBTree::RayEntry(grow(bounds), bullet.Start, displacement, fraction);
+				if (entry >= 0.f && entry < fraction)
+				{
+					fraction = entry;
+					normal = AABBTree::EntryNormal(grow(bounds), bullet.Start, displacement);
+				}
+			};
+
+			m_staticBatch.ForEachOverlap(sweptBounds, 0, m_staticBatch.Size(), [&](size_t candidate) {
+				const std::uint32_t other = m_staticBodies[candidate];
+				cast(m_bounds[other], m_filters[other]);
+			});
+
+			m_sleeping->GetTree().Traverse(
+				[&](AABB const& nodeBounds) { return AABBTree::RayEntry(grow(nodeBounds), bullet.Start, displacement, fraction) >= 0.f; },
+				[&](std::uint32_t proxy) {
+					cast(m_sleeping->GetBounds(proxy), GetSleepState(m_sleeping->GetEntity(proxy)).CollisionFilter);
+					return true;
+				});
+
+			if (fraction < 1.f)
+			{
+				body.Position = bullet.Start + displacement * fraction - normal * SweepSkin;
+				m_bounds[bullet.Body] = { body.Position - halfSize, body.Position + halfSize };
+			}
+		}
+	}
+
+	static constexpr std::uint32_t NoIsland = std::numeric_limits<std::uint32_t>::max();
+	static constexpr std::uint32_t NotActive = std::numeric_limits<std::uint32_t>::max();
+
+	// Kept per entity: how long the body has been quiet, where it is in m_active and, while it
+	// sleeps, its island and the collider settings it fell asleep with
+	struct SleepState
+	{
+		ecs::Entity Entity = ecs::InvalidEntity;
+		std::uint32_t QuietFrames = 0;
+		std::uint32_t Island = NoIsland;
+		std::uint32_t ActiveSlot = NotActive;
+		Filter CollisionFilter = {};
+	};
+
+	// A reused entity index starts over
+	SleepState& GetSleepState(ecs::Entity entity)
+	{
+		const size_t index = entity.Index();
+		if (index >= m_sleepStates.size())
+		{
+			m_sleepStates.resize(index + 1);
+		}
+
+		SleepState& state = m_sleepStates[index];
+		if (state.Entity != entity)
+		{
+			state = SleepState{};
+			state.Entity = entity;
+		}
+		return state;
+	}
+
+	void Activate(SleepState& state)
+	{
+		assert(state.ActiveSlot == NotActive && "Body is active already");
+
+		state.ActiveSlot = static_cast<std::uint32_t>(m_active.size());
+		m_active.push_back(state.Entity);
+	}
+
+	void Deactivate(SleepState& state)
+	{
+		const ecs::Entity last = m_active.back();
+		m_active[state.ActiveSlot] = last;
+		m_sleepStates[last.Index()].ActiveSlot = state.ActiveSlot;
+		m_active.pop_back();
+		state.ActiveSlot = NotActive;
+	}
+
+	// Wakes the islands queued since the last step
+	void WakeIslands(ecs::Scene& scene)
+	{
+		for (std::uint32_t island : m_wakeIslands)
+		{
+			WakeIsland(scene, island, false);
+		}
+		m_wakeIslands.clear();
+	}
+
+	// Clears Sleeping on the bodies of the island and moves them from m_sleeping back to m_active,
+	// and to this step when addToStep is set. Queued islands may have woken already.
+	void WakeIsland(ecs::Scene& scene, std::uint32_t island, bool addToStep)
+	{
+		using namespace physics::components;
+
+		auto members = m_islandMembers.find(island);
+		if (members == m_islandMembers.end())
+		{
+			return;
+		}
+
+		for (ecs::Entity entity : members->second)
+		{
+			// Left the system while the island slept
+			SleepState& state = m_sleepStates[entity.Index()];
+			if (state.Entity != entity || state.Island != island)
+			{
+				continue;
+			}
+
+			auto& rigidBody = scene.GetComponent<RigidBody>(entity);
+			rigidBody.Sleeping = false;
+			state.Island = NoIsland;
+			state.QuietFrames = 0;
+
+			// Sleeping sensors are in the step already
+			if (state.CollisionFilter.Sensor)
+			{
+				m_changed.push_back(entity);
+				continue;
+			}
+
+			m_sleeping->Remove(entity);
+			Activate(state);
+			if (addToStep)
+			{
+				AddBody(entity, scene.GetComponent<Transform>(entity).Position, rigidBody, scene.GetComponent<AABBCollider>(entity), false);
+			}
+		}
+
+		m_islandMembers.erase(members);
+	}
+
+	// Wakes the sleeping islands an awake dynamic body overlaps in this step and adds their bodies
+	// to it before the broadphase update, so the hit pushes them instead of bouncing off them as off
+	// a static body and their own contacts are found this step. Woken bodies may wake more islands.
+	void WakeTouchedIslands(ecs::Scene& scene)
+	{
+		for (std::uint32_t checked = 0; checked < m_bodies.size();)
+		{
+			const std::uint32_t bodyCount = static_cast<std::uint32_t>(m_bodies.size());
+			for (std::uint32_t body = checked; body < bodyCount; ++body)
+			{
+				if (m_kinds[body] != BodyKind::Dynamic || m_filters[body].Sensor)
+				{
+					continue;
+				}
+
+				m_sleeping->GetTree().Query(m_bounds[body], [&](std::uint32_t proxy) {
+					SleepState const& state = GetSleepState(m_sleeping->GetEntity(proxy));
+					if (m_sleeping->GetBounds(proxy).Intersects(m_bounds[body]) && ShouldCollide(m_filters[body], state.CollisionFilter))
+					{
+						m_wakeIslands.push_back(state.Island);
+					}
+					return true;
+				});
+			}
+			checked = bodyCount;
+
+			for (std::uint32_t island : m_wakeIslands)
+			{
+				WakeIsland(scene, island, true);
+			}
+			m_wakeIslands.clear();
+		}
+	}
+
+	// Puts islands to sleep once all their bodies have been quiet for SleepFrames steps and moves
+	// their colliders from the broadphase to m_sleeping
+	void SleepIslands(ecs::Scene& scene)
+	{
+		using namespace physics::components;
+
+		const float sleepVelocitySq = m_settings.SleepVelocity * m_settings.SleepVelocity;
+
+		m_rootQuietFrames.assign(m_bodies.size(), std::numeric_limits<std::uint32_t>::max());
+		for (std::uint32_t body = 0; body < m_bodies.size(); ++body)
+		{
+			if (m_kinds[body] != BodyKind::Dynamic)
+			{
+				continue;
+			}
+
+			SleepState& state = GetSleepState(m_entities[body]);
+			state.QuietFrames = Dot(m_bodies[body].Velocity, m_bodies[body].Velocity) < sleepVelocitySq ? state.QuietFrames + 1 : 0;
+
+			std::uint32_t& rootQuietFrames = m_rootQuietFrames[m_islands.GetRoot(body)];
+			rootQuietFrames = std::min(rootQuietFrames, state.QuietFrames);
+		}
+
+		m_rootIslands.assign(m_bodies.size(), NoIsland);
+		for (std::uint32_t body = 0; body < m_bodies.size(); ++body)
+		{
+			if (m_kinds[body] != BodyKind::Dynamic)
+			{
+				continue;
+			}
+
+			const std::uint32_t root = m_islands.GetRoot(body);
+			if (m_rootQuietFrames[root] < static_cast<std::uint32_t>(m_settings.SleepFrames))
+			{
+				continue;
+			}
+
+			if (m_rootIslands[root] == NoIsland)
+			{
+				m_rootIslands[root] = m_nextIsland++;
+				// Skips the marker once the counter wraps
+				m_nextIsland = m_nextIsland == NoIsland ? 0 : m_nextIsland;
+			}
+
+			auto& rigidBody = scene.GetComponent<RigidBody>(m_entities[body]);
+			rigidBody.Sleeping = true;
+			rigidBody.Velocity = {};
+
+			SleepState& state = GetSleepState(m_entities[body]);
+			state.Island = m_rootIslands[root];
+			state.CollisionFilter = m_filters[body];
+			m_islandMembers[state.Island].push_back(m_entities[body]);
+
+			if (!m_filters[body].Sensor)
+			{
+				const math::Vector2 halfSize = m_bodies[body].Size * 0.5f;
+				m_sleeping->Insert(m_entities[body], { m_bodies[body].Position - halfSize, m_bodies[body].Position + halfSize });
+				Deactivate(state);
+			}
+		}
+	}
+
+	// Static and sleeping bodies can sit in several islands solved in parallel, so they are only read
+	void ApplyImpulse(Contact const& contact, float impulse)
+	{
+		const math::Vector2 vector = impulse * contact.Normal;
+		Body& a = m_bodies[contact.BodyA];
+		Body& b = m_bodies[contact.BodyB];
+		if (a.InvMass > 0.f)
+		{
+			a.Velocity += vector * a.InvMass;
+		}
+		if (b.InvMass > 0.f)
+		{
+			b.Velocity -= vector * b.InvMass;
+		}
+	}
+
+	PhysicsSettings m_settings;
+	std::shared_ptr<IBroadphase> m_broadphase;
+	// Set when the broadphase is the AABB tree, handed to the Query resource
+	std::shared_ptr<TreeBroadphase> m_tree;
+	// Colliders of the step handed to the Query resource in place of the tree
+	std::shared_ptr<BoundsList> m_colliders;
+
+	std::vector<ecs::Entity> m_entities;
+	// Bodies whose Transform or RigidBody this step wrote
+	std::vector<ecs::Entity> m_changed;
+	bool m_marking = false;
+	std::vector<math::AABB> m_bounds;
+	std::vector<BodyKind> m_kinds;
+	std::vector<BodyKind> m_broadphaseKinds;
+	std::vector<Body> m_bodies;
+	std::vector<Filter> m_filters;
+	std::vector<Bullet> m_bullets;
+	std::vector<std::uint32_t> m_sensors;
+	// Static colliders of this step and their bodies, gathered only when there are bullets
+	math::AABBBatch m_staticBatch;
+	std::vector<std::uint32_t> m_staticBodies;
+	std::vector<BroadphasePair> m_solvePairs;
+	std::vector<EntityPair> m_sensorCandidates;
+	details::PairDiff m_sensorPairs;
+	std::vector<Contact> m_contacts;
+	details::IslandBuilder m_islands;
+
+	ContactCache m_contactCache;
+	std::vector<ContactCache::Entry> m_cacheEntries;
+
+	// Shared with the Query resource
+	std::shared_ptr<SleepingBodies> m_sleeping = std::make_shared<SleepingBodies>();
+	// Indexed by entity index
+	std::vector<SleepState> m_sleepStates;
+	// Bodies stepped each update, the awake ones and sleeping sensors. Kept up by the entity hooks
+	// so sleeping bodies cost nothing per step.
+	std::vector<ecs::Entity> m_active;
+	// Bodies of each sleeping island as it fell asleep
+	std::unordered_map<std::uint32_t, std::vector<ecs::Entity>> m_islandMembers;
+	// Islands to wake: gameplay changed or removed one of their bodies, or an awake body touched them
+	std::vector<std::uint32_t> m_wakeIslands;
+	std::uint32_t m_nextIsland = 0;
+	std::vector<std::uint32_t> m_rootQuietFrames;
+	std::vector<std::uint32_t> m_rootIslands;
 };
 
 } // namespace Engine::physics
@@ -0,0 +1,312 @@
+#pragma once
+
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "../ECS/Scene/Scene.h"
+#include "../ECS/System/System.h"
+
+#include "Components.h"
+
+namespace Engine::physics
+{
+
+// Computes WorldTransform for entities with Transform and Hierarchy. Register with
+// WithRead<Transform>().WithRead<Hierarchy>().WithWrite<WorldTransform>().
+// A parent has to carry Hierarchy as well and be enabled, otherwise its children are treated as roots.
+// After the order changes, the Hierarchy, Transform and WorldTransform pools are put in depth-first
+// order at the next ConfirmChanges, and the pass then walks their dense arrays front to front.
+// Until then, or when something else reorders those pools, it looks components up per entity.
+class TransformSystem : public ecs::System
+{
+public:
+	void Update(ecs::Scene& scene, float) override
+	{
+		bool ordered = IsOrdered(scene);
+		if (HierarchyChanged(scene, ordered))
+		{
+			RebuildOrder(scene);
+			ordered = false;
+		}
+
+		if (!ordered)
+		{
+			RequestOrder(scene);
+		}
+
+		scene.ParallelFor(m_roots.size(), RootsPerTask, [&](size_t begin, size_t end) {
+			for (size_t root = begin; root < end; ++root)
+			{
+				if (ordered)
+				{
+					Propagate(scene.GetComponents<components::Transform>(), scene.GetComponents<components::WorldTransform>(), m_roots[root].Begin, m_roots[root].End);
+				}
+				else
+				{
+					Propagate(scene, m_roots[root].Begin, m_roots[root].End);
+				}
+			}
+		});
+
+		m_forceUpdate = false;
+	}
+
+private:
+	static constexpr size_t NoParent = std::numeric_limits<size_t>::max();
+	static constexpr size_t RootsPerTask = 8;
+
+	struct Node
+	{
+		ecs::Entity Entity = ecs::InvalidEntity;
+		ecs::Entity ParentEntity = ecs::InvalidEntity;
+		size_t Parent = NoParent;
+		components::Transform Local;
+		math::Matrix3x2 World;
+		bool Changed = false;
+	};
+
+	struct RootRange
+	{
+		size_t Begin;
+		size_t End;
+	};
+
+	// Whether the pools lead with the nodes in depth-first order
+	bool IsOrdered(ecs::Scene& scene) const
+	{
+		auto isOrdered = [&](std::span<ecs::Entity const> entities) {
+			if (entities.size() < m_nodes.size())
+			{
+				return false;
+			}
+
+			for (size_t i = 0; i < m_nodes.size(); ++i)
+			{
+				if (entities[i] != m_nodes[i].Entity)
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+
+		return isOrdered(scene.GetComponentEntities<components::Hierarchy>())
+			&& isOrdered(scene.GetComponentEntities<components::Transform>())
+			&& isOrdered(scene.GetComponentEntities<components::WorldTransform>());
+	}
+
+	// Moves the pools into depth-first order once the systems are done, at most once per frame
+	void RequestOrder(ecs::Scene& scene)
+	{
+		if (m_orderRequested)
+		{
+			return;
+		}
+
+		m_orderRequested = true;
+		scene.Defer([this](ecs::Scene& scene) {
+			m_orderRequested = false;
+
+			// Entities removed in this ConfirmChanges leave the order to the next rebuild
+			std::vector<ecs::Entity> order;
+			order.reserve(m_nodes.size());
+			for (Node const& node : m_nodes)
+			{
+				if (!scene.HasComponent<components::Hierarchy>(node.Entity) || !scene.HasComponent<components::Transform>(node.Entity)
+					|| !scene.HasComponent<components::WorldTransform>(node.Entity))
+				{
+					return;
+				}
+				order.push_back(node.Entity);
+			}
+
+			scene.Order<components::Hierarchy, components::Transform, components::WorldTransform>(order);
+		});
+	}
+
+	bool HierarchyChanged(ecs::Scene& scene, bool ordered) const
+	{
+		if (Entities.size() != m_members.size())
+		{
+			return true;
+		}
+
+		for (size_t i = 0; i < Entities.size(); ++i)
+		{
+			if (Entities[i].GetEntity() != m_members[i])
+			{
+				return true;
+			}
+		}
+
+		if (ordered)
+		{
+			auto hierarchies = scene.GetComponents<components::Hierarchy>();
+			for (size_t i = 0; i < m_nodes.size(); ++i)
+			{
+				if (hierarchies[i].Parent != m_nodes[i].ParentEntity)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		for (auto const& node : m_nodes)
+		{
+			if (scene.GetComponent<components::Hierarchy>(node.Entity).Parent != node.ParentEntity)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Lays nodes out depth-first so every subtree is a contiguous range that follows its parent
+	void RebuildOrder(ecs::Scene& scene)
+	{
+		const size_t count = Entities.size();
+
+		m_members.resize(count);
+		std::vector<size_t> parentOf(count, NoParent);
+		std::vector<size_t> childOffsets(count + 1, 0);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			m_members[i] = Entities[i].GetEntity();
+
+			ecs::Entity parent = scene.GetComponent<components::Hierarchy>(m_members[i]).Parent;
+			if (auto it = EntityToIndexMap.find(parent); it != EntityToIndexMap.end() && it->second != i)
+			{
+				parentOf[i] = it->second;
+				childOffsets[it->second + 1]++;
+			}
+		}
+
+		for (size_t i = 1; i <= count; ++i)
+		{
+			childOffsets[i] += childOffsets[i - 1];
+		}
+
+		std::vector<size_t> children(childOffsets.back());
+		std::vector<size_t> cursor(childOffsets.begin(), childOffsets.end() - 1);
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (parentOf[i] != NoParent)
+			{
+				children[cursor[parentOf[i]]++] = i;
+			}
+		}
+
+		m_nodes.clear();
+		m_roots.clear();
+		m_nodes.reserve(count);
+
+		std::vector<size_t> nodeOf(count, NoParent);
+		std::vector<size_t> stack;
+
+		auto visitTree = [&](size_t root) {
+			const size_t begin = m_nodes.size();
+			stack.push_back(root);
+
+			while (!stack.empty())
+			{
+				const size_t member = stack.back();
+				stack.pop_back();
+
+				if (nodeOf[member] != NoParent)
+				{
+					continue;
+				}
+
+				nodeOf[member] = m_nodes.size();
+
+				Node node;
+				node.Entity = m_members[member];
+				node.ParentEntity = scene.GetComponent<components::Hierarchy>(node.Entity).Parent;
+				node.Parent = member == root || parentOf[member] == NoParent ? NoParent : nodeOf[parentOf[member]];
+				m_nodes.push_back(node);
+
+				for (size_t child = childOffsets[member + 1]; child > childOffsets[member]; --child)
+				{
+					stack.push_back(children[child - 1]);
+				}
+			}
+
+			m_roots.push_back({ begin, m_nodes.size() });
+		};
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (parentOf[i] == NoParent)
+			{
+				visitTree(i);
+			}
+		}
+
+		// Members left unvisited form parent cycles, the first one reached is promoted to a root
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (nodeOf[i] == NoParent)
+			{
+				visitTree(i);
+			}
+		}
+
+		m_forceUpdate = true;
+	}
+
+	// Pools in depth-first order, node i owns component i of each
+	void Propagate(std::span<components::Transform const> locals, std::span<components::WorldTransform> worlds, size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			if (UpdateNode(m_nodes[i], locals[i]))
+			{
+				worlds[i].Matrix = m_nodes[i].World;
+			}
+		}
+	}
+
+	void Propagate(ecs::Scene& scene, size_t begin, size_t end)
+	{
+		using namespace physics::components;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			Node& node = m_nodes[i];
+			if (UpdateNode(node, scene.GetComponent<Transform>(node.Entity)))
+			{
+				scene.GetComponent<WorldTransform>(node.Entity).Matrix = node.World;
+			}
+		}
+	}
+
+	// Recomputes the node's world matrix when it or its parent changed, returns whether it did
+	bool UpdateNode(Node& node, components::Transform const& local)
+	{
+		const bool parentChanged = node.Parent != NoParent && m_nodes[node.Parent].Changed;
+		node.Changed = m_forceUpdate || parentChanged || !(local == node.Local);
+
+		if (!node.Changed)
+		{
+			return false;
+		}
+
+		node.Local = local;
+
+		const auto localMatrix = math::Matrix3x2::FromTransform(local.Position, local.Rotation, local.Scale);
+		node.World = node.Parent == NoParent ? localMatrix : m_nodes[node.Parent].World * localMatrix;
+		return true;
+	}
+
+	std::vector<ecs::Entity> m_members;
+	std::vector<Node> m_nodes;
+	std::vector<RootRange> m_roots;
+	bool m_forceUpdate = true;
+	bool m_orderRequested = false;
+};
+
+} // namespace Engine::physics
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+#include "../ECS/Entity/Entity.h"
+#include "../Math/Vector2.h"
+
+#include "AABBTree.h"
+#include "Broadphase.h"
+
+namespace Engine::physics
+{
+
+// Static and dynamic bodies in separate AABB trees. Pairs whose fat bounds overlap are kept
+// between steps and only bodies that left their fat bounds query the trees again, so a level of
+// resting static geometry costs nothing once built. Static bodies never pair with each other.
+class TreeBroadphase final : public IBroadphase
+{
+public:
+	explicit TreeBroadphase(float margin = 10.f)
+		: m_trees{ AABBTree(margin), AABBTree(margin) }
+	{
+	}
+
+	void Update(std::span<ecs::Entity const> entities, std::span<math::AABB const> bounds, std::span<BodyKind const> kinds) override
+	{
+		m_stamp++;
+		m_moved.clear();
+
+		SyncProxies(entities, bounds, kinds);
+		RemoveFatPairs();
+		FreeStaleProxies();
+		AddFatPairs();
+
+		m_pairs.clear();
+		for (std::uint64_t key : m_fatPairs)
+		{
+			Proxy const& first = m_proxies[static_cast<std::uint32_t>(key >> 32)];
+			Proxy const& second = m_proxies[static_cast<std::uint32_t>(key)];
+			if (first.Bounds.Intersects(second.Bounds))
+			{
+				m_pairs.push_back({ std::min(first.Index, second.Index), std::max(first.Index, second.Index) });
+			}
+		}
+
+		std::sort(m_pairs.begin(), m_pairs.end(), [](BroadphasePair const& lhs, BroadphasePair const& rhs) {
+			return lhs.Key() < rhs.Key();
+		});
+
+		m_diff.Update(entities, m_pairs);
+	}
+
+	std::span<BroadphasePair const> GetPairs() const override
+	{
+		return m_pairs;
+	}
+
+	std::span<EntityPair const> GetAddedPairs() const override
+	{
+		return m_diff.GetAdded();
+	}
+
+	std::span<EntityPair const> GetRemovedPairs() const override
+	{
+		return m_diff.GetRemoved();
+	}
+
+	std::shared_ptr<IBroadphase> Clone() const override
+	{
+		return std::make_shared<TreeBroadphase>(*this);
+	}
+
+	// Leaves carry proxy ids, GetEntity maps them back
+	AABBTree const& GetTree(BodyKind kind) const
+	{
+		return m_trees[static_cast<size_t>(kind)];
+	}
+
+	ecs::Entity GetEntity(std::uint32_t proxy) const
+	{
+		return m_proxies[proxy].Entity;
+	}
+
+	// Tight bounds of the proxy as of the last update
+	math::AABB const& GetBounds(std::uint32_t proxy) const
+	{
+		return m_proxies[proxy].Bounds;
+	}
+
+private:
+	static constexpr std::uint32_t NoProxy = std::numeric_limits<std::uint32_t>::max();
+
+	struct Proxy
+	{
+		ecs::Entity Entity = ecs::InvalidEntity;
+		math::AABB Bounds;
+		std::int32_t Node = AABBTree::NullNode;
+		BodyKind Kind = BodyKind::Dynamic;
+		// Position in the spans of the current update
+		std::uint32_t Index = 0;
+		std::uint32_t Stamp = 0;
+	};
+
+	static std::uint64_t PairKey(std::uint32_t a, std::uint32_t b)
+	{
+		return a < b ? (static_cast<std::uint64_t>(a) << 32) | b : (static_cast<std::uint64_t>(b) << 32) | a;
+	}
+
+	AABBTree& GetTree(BodyKind kind)
+	{
+		return m_trees[static_cast<size_t>(kind)];
+	}
+
+	bool IsStale(Proxy const& proxy) const
+	{
+		return proxy.Entity != ecs::InvalidEntity && proxy.Stamp != m_stamp;
+	}
+
+	void SyncProxies(std::span<ecs::Entity const> entities, std::span<math::AABB const> bounds, std::span<BodyKind const> kinds)
+	{
+		for (std::uint32_t i = 0; i < entities.size(); ++i)
+		{
+			const ecs::Entity entity = entities[i];
+			const size_t index = entity.Index();
+
+			if (index >= m_proxyOfEntity.size())
+			{
+				m_proxyOfEntity.resize(index + 1, NoProxy);
+			}
+
+			std::uint32_t id = m_proxyOfEntity[index];
+			if (id == NoProxy || m_proxies[id].Entity != entity)
+			{
+				id = AllocateProxy();
+				m_proxyOfEntity[index] = id;
+
+				Proxy& proxy = m_proxies[id];
+				proxy = { entity, bounds[i], GetTree(kinds[i]).CreateProxy(bounds[i], id), kinds[i], i, m_stamp };
+				m_moved.push_back(id);
+				continue;
+			}
+
+			Proxy& proxy = m_proxies[id];
+			proxy.Bounds = bounds[i];
+			proxy.Index = i;
+			proxy.Stamp = m_stamp;
+
+			if (proxy.Kind != kinds[i])
+			{
+				GetTree(proxy.Kind).DestroyProxy(proxy.Node);
+				proxy.Kind = kinds[i];
+				proxy.Node = GetTree(proxy.Kind).CreateProxy(bounds[i], id);
+				m_moved.push_back(id);
+			}
+			else if (GetTree(proxy.Kind).MoveProxy(proxy.Node, bounds[i]))
+			{
+				m_moved.push_back(id);
+			}
+		}
+	}
+
+	// Drops pairs whose fat bounds separated, that lost a proxy or that became static
+	void RemoveFatPairs()
+	{
+		std::erase_if(m_fatPairs, [this](std::uint64_t key) {
+			Proxy const& first = m_proxies[static_cast<std::uint32_t>(key >> 32)];
+			Proxy const& second = m_proxies[static_cast<std::uint32_t>(key)];
+
+			return IsStale(first) || IsStale(second)
+				|| (first.Kind == BodyKind::Static && second.Kind == BodyKind::Static)
+				|| !GetTree(first.Kind).GetFatBounds(first.Node).Intersects(GetTree(second.Kind).GetFatBounds(second.Node));
+		});
+	}
+
+	void FreeStaleProxies()
+	{
+		for (std::uint32_t id = 0; id < m_proxies.size(); ++id)
+		{
+			Proxy& proxy = m_proxies[id];
+			if (!IsStale(proxy))
+			{
+				continue;
+			}
+
+			if (m_proxyOfEntity[proxy.Entity.Index()] == id)
+			{
+				m_proxyOfEntity[proxy.Entity.Index()] = NoProxy;
+			}
+
+			GetTree(proxy.Kind).DestroyProxy(proxy.Node);
+			proxy.Entity = ecs::InvalidEntity;
+			proxy.Node = AABBTree::NullNode;
+			m_freeProxies.push_back(id);
+		}
+	}
+
+	void AddFatPairs()
+	{
+		for (std::uint32_t id : m_moved)
+		{
+			Proxy const& proxy = m_proxies[id];
+			math::AABB const& fatBounds = GetTree(proxy.Kind).GetFatBounds(proxy.Node);
+
+			auto addPair = [&](std::uint32_t other) {
+				if (other != id)
+				{
+					m_fatPairs.insert(PairKey(id, other));
+				}
+				return true;
+			};
+
+			GetTree(BodyKind::Dynamic).Query(fatBounds, addPair);
+			if (proxy.Kind == BodyKind::Dynamic)
+			{
+				GetTree(BodyKind::Static).Query(fatBounds, addPair);
+			}
+		}
+	}
+
+	std::uint32_t AllocateProxy()
+	{
+		if (!m_freeProxies.empty())
+		{
+			const std::uint32_t id = m_freeProxies.back();
+			m_freeProxies.pop_back();
+			return id;
+		}
+
+		m_proxies.emplace_back();
+		return static_cast<std::uint32_t>(m_proxies.size() - 1);
+	}
+
+	std::array<AABBTree, 2> m_trees;
+
+	std::vector<Proxy> m_proxies;
+	std::vector<std::uint32_t> m_freeProxies;
+	std::uint32_t m_stamp = 0;
+
+	// Indexed by entity index
+	std::vector<std::uint32_t> m_proxyOfEntity;
+
+	std::vector<std::uint32_t> m_moved;
+	std::unordered_set<std::uint64_t> m_fatPairs;
+
+	std::vector<BroadphasePair> m_pairs;
+	details::PairDiff m_diff;
+};
+
+} // namespace Engine::physics
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include "../ECS/Scene/Scene.h"
+#include "../ECS/SystemManager/WorkerPool.h"
+#include "../Math/Vector2.h"
+
+#include "Components.h"
+
+namespace Engine::physics
+{
+
+// Splits the world into square cells by Transform::Position. A cell far from every focus point is
+// written to disk and its entities destroyed; once a focus point comes close again the file is read
+// on a loader thread and the entities come back through Scene::QueueBatch at the next ConfirmChanges,
+// so a frame never waits on I/O. Entities come back with new handles: components that reference
+// other entities (Hierarchy::Parent) are not remapped, keep such groups inside one cell.
+// Loader threads use the scene, it has to outlive the partition.
+class WorldPartition
+{
+public:
+	struct Cell
+	{
+		std::int32_t X = 0;
+		std::int32_t Y = 0;
+
+		bool operator==(Cell const&) const = default;
+	};
+
+	enum class CellState
+	{
+		// In the scene, the state of every cell that was never evicted
+		Resident,
+		// Entities are destroyed, the file is being written
+		Saving,
+		Evicted,
+		// File is being read, or the batch waits for ConfirmChanges
+		Loading,
+		// The file couldn't be written or read, the cell is left alone
+		Failed
+	};
+
+	WorldPartition(std::filesystem::path directory, float cellSize, size_t loaderThreads = 2)
+		: m_state(std::make_shared<State>())
+		, m_directory(std::move(directory))
+		, m_cellSize(cellSize)
+		, m_loaders(std::make_unique<ecs::details::WorkerPool>(std::max<size_t>(loaderThreads, 1)))
+	{
+		assert(cellSize > 0.f && "Cell size must be positive");
+		std::filesystem::create_directories(m_directory);
+	}
+
+	WorldPartition(WorldPartition const&) = delete;
+	WorldPartition& operator=(WorldPartition const&) = delete;
+
+	Cell GetCell(math::Vector2 const& position) const
+	{
+		return { static_cast<std::int32_t>(std::floor(position.X / m_cellSize)),
+			static_cast<std::int32_t>(std::floor(position.Y / m_cellSize)) };
+	}
+
+	CellState GetState(Cell cell) const
+	{
+		std::lock_guard<std::mutex> lock(m_state->Mutex);
+
+		auto it = m_state->Cells.find(cell);
+		return it != m_state->Cells.end() ? it->second : CellState::Resident;
+	}
+
+	// Call once per frame before ConfirmChanges. Evicted cells within loadRadius cells of a focus
+	// point start loading, resident cells further than unloadRadius from all of them are evicted.
+	void Update(ecs::Scene& scene, std::span<math::Vector2 const> focusPoints, std::int32_t loadRadius, std::int32_t unloadRadius)
+	{
+		assert(unloadRadius >= loadRadius && "Cells would be evicted and loaded in turns");
+
+		std::vector<Cell> focusCells;
+		focusCells.reserve(focusPoints.size());
+		for (math::Vector2 const& point : focusPoints)
+		{
+			focusCells.push_back(GetCell(point));
+		}
+
+		auto distance = [&](Cell cell) {
+			std::int32_t nearest = std::numeric_limits<std::int32_t>::max();
+			for (Cell focus : focusCells)
+			{
+				nearest = std::min(nearest, std::max(std::abs(cell.X - focus.X), std::abs(cell.Y - focus.Y)));
+			}
+			return nearest;
+		};
+
+		std::vector<Cell> toLoad;
+		{
+			std::lock_guard<std::mutex> lock(m_state->Mutex);
+			for (auto const& [cell, state] : m_state->Cells)
+			{
+				if (state == CellState::Evicted && distance(cell) <= loadRadius)
+				{
+					toLoad.push_back(cell);
+				}
+			}
+		}
+
+		for (Cell cell : toLoad)
+		{
+			Load(scene, cell);
+		}
+
+		std::unordered_map<Cell, std::vector<ecs::Entity>, CellHash> toEvict;
+
+		auto transforms = scene.GetComponents<components::Transform>();
+		auto entities = scene.GetComponentEntities<components::Transform>();
+		for (size_t i = 0; i < transforms.size(); ++i)
+		{
+			const Cell cell = GetCell(transforms[i].Position);
+			if (distance(cell) > unloadRadius)
+			{
+				toEvict[cell].push_back(entities[i]);
+			}
+		}
+
+		for (auto const& [cell, cellEntities] : toEvict)
+		{
+			if (GetState(cell) == CellState::Resident)
+			{
+				Evict(scene, cell, cellEntities);
+			}
+		}
+	}
+
+	// Destroys every entity whose Transform lies in cell and writes them to the cell's file
+	void Evict(ecs::Scene& scene, Cell cell)
+	{
+		std::vector<ecs::Entity> cellEntities;
+
+		auto transforms = scene.GetComponents<components::Transform>();
+		auto entities = scene.GetComponentEntities<components::Transform>();
+		for (size_t i = 0; i < transforms.size(); ++i)
+		{
+			if (GetCell(transforms[i].Position) == cell)
+			{
+				cellEntities.push_back(entities[i]);
+			}
+		}
+
+		Evict(scene, cell, cellEntities);
+	}
+
+	// Reads the cell's file on a loader thread, the entities appear at a later ConfirmChanges
+	void Load(ecs::Scene& scene, Cell cell)
+	{
+		if (!SetState(cell, CellState::Evicted, CellState::Loading))
+		{
+			return;
+		}
+
+		auto batch = std::make_shared<ecs::EntityBatch>(scene.CreateBatch());
+		batch->OnInserted = [state = m_state, cell](std::span<ecs::Entity const>) {
+			std::lock_guard<std::mutex> lock(state->Mutex);
+			state->Cells.erase(cell);
+		};
+
+		m_loaders->Submit([state = m_state, &scene, cell, batch, path = GetPath(cell)]() {
+			bool read = false;
+			{
+				std::ifstream file(path, std::ios::binary);
+				read = file && batch->Read(file);
+			}
+
+			if (!read)
+			{
+				std::lock_guard<std::mutex> lock(state->Mutex);
+				state->Cells[cell] = CellState::Failed;
+				return;
+			}
+
+			std::error_code error;
+			std::filesystem::remove(path, error);
+
+			scene.QueueBatch(std::move(*batch));
+		});
+	}
+
+	std::filesystem::path GetPath(Cell cell) const
+	{
+		return m_directory / ("cell_" + std::to_string(cell.X) + "_" + std::to_string(cell.Y) + ".ecsb");
+	}
+
+private:
+	struct CellHash
+	{
+		size_t operator()(Cell const& cell) const
+		{
+			return std::hash<std::uint64_t>{}((static_cast<std::uint64_t>(static_cast<std::uint32_t>(cell.X)) << 32)
+				| static_cast<std::uint32_t>(cell.Y));
+		}
+	};
+
+	// Shared with loader tasks and OnInserted callbacks, which may outlive the partition
+	struct State
+	{
+		std::mutex Mutex;
+		// Cells without an entry are resident
+		std::unordered_map<Cell, CellState, CellHash> Cells;
+	};
+
+	bool SetState(Cell cell, CellState expected, CellState state)
+	{
+		std::lock_guard<std::mutex> lock(m_state->Mutex);
+
+		auto it = m_state->Cells.find(cell);
+		const CellState current = it != m_state->Cells.end() ? it->second : CellState::Resident;
+		if (current != expected)
+		{
+			return false;
+		}
+
+		m_state->Cells[cell] = state;
+		return true;
+	}
+
+	void Evict(ecs::Scene& scene, Cell cell, std::span<ecs::Entity const> entities)
+	{
+		if (!SetState(cell, CellState::Resident, CellState::Saving))
+		{
+			return;
+		}
+
+		auto batch = std::make_shared<ecs::EntityBatch>(scene.CopyToBatch(entities));
+		for (ecs::Entity entity : entities)
+		{
+			scene.DestoryEntity(entity);
+		}
+
+		m_loaders->Submit([state = m_state, &scene, cell, batch, path = GetPath(cell)]() {
+			bool written = false;
+			{
+				std::ofstream file(path, std::ios::binary | std::ios::trunc);
+				written = file && batch->Write(file) && file.flush();
+			}
+
+			if (written)
+			{
+				std::lock_guard<std::mutex> lock(state->Mutex);
+				state->Cells[cell] = CellState::Evicted;
+				return;
+			}
+
+			// Nothing is lost on a failed write, the entities go back into the scene
+			{
+				std::lock_guard<std::mutex> lock(state->Mutex);
+				state->Cells[cell] = CellState::Failed;
+			}
+			batch->OnInserted = nullptr;
+			scene.QueueBatch(std::move(*batch));
+		});
+	}
+
+	std::shared_ptr<State> m_state;
+	std::filesystem::path m_directory;
+	float m_cellSize;
+
+	// Declared last so pending reads and writes finish before the rest is destroyed
+	std::unique_ptr<ecs::details::WorkerPool> m_loaders;
+};
+
+} // namespace Engine::physics
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <physics.hpp>
+
+namespace AABBOverlapBenchmark
+{
+
+using namespace Engine;
+
+// Every box against every box, once through AABB::Intersects and once through AABBBatch
+inline void Run()
+{
+	std::cout << "--- AABB Overlap Benchmark ---" << std::endl;
+#if ENGINE_AABB_AVX2
+	std::cout << "Kernel: AVX2" << std::endl;
+#elif ENGINE_AABB_SSE2
+	std::cout << "Kernel: SSE2" << std::endl;
+#else
+	std::cout << "Kernel: scalar" << std::endl;
+#endif
+
+	const int boxCount = 8192;
+
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> position(0.f, 10'000.f);
+	std::uniform_real_distribution<float> size(10.f, 200.f);
+
+	std::vector<math::AABB> boxes;
+	math::AABBBatch batch;
+	for (int i = 0; i < boxCount; ++i)
+	{
+		const math::Vector2 min = { position(rng), position(rng) };
+		boxes.push_back({ min, { min.X + size(rng), min.Y + size(rng) } });
+		batch.Add(boxes.back());
+	}
+
+	const double tests = static_cast<double>(boxCount) * boxCount;
+
+	auto start = std::chrono::steady_clock::now();
+	std::uint64_t scalarHits = 0;
+	for (math::AABB const& box : boxes)
+	{
+		for (math::AABB const& other : boxes)
+		{
+			scalarHits += box.Intersects(other);
+		}
+	}
+	const std::chrono::duration<double> scalar = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	std::uint64_t batchHits = 0;
+	for (math::AABB const& box : boxes)
+	{
+		for (size_t block = 0; block < batch.BlockCount(); ++block)
+		{
+			batchHits += std::popcount(batch.OverlapMask(box, block));
+		}
+	}
+	const std::chrono::duration<double> batched = std::chrono::steady_clock::now() - start;
+
+	std::cout << "Tests: " << tests << ", overlaps: " << scalarHits << " / " << batchHits << std::endl;
+	std::cout << "   Intersects: " << tests / scalar.count() / 1e6 << " M tests/s" << std::endl;
+	std::cout << "   AABBBatch: " << tests / batched.count() / 1e6 << " M tests/s" << std::endl;
+	std::cout << "   Speedup: " << scalar.count() / batched.count() << "x" << std::endl;
+}
+
+} // namespace AABBOverlapBenchmark
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <utility>
+
+#include <ecs.hpp>
+#include <physics.hpp>
+
+namespace BroadphaseBenchmark
+{
+
+using namespace Engine;
+using namespace Engine::physics;
+using namespace Engine::physics::components;
+
+// Seconds per PhysicsSystem step over `frames` steps with bodies at a fixed density,
+// staticShare of them resting with zero mass
+inline double MeasureStep(BroadphaseKind broadphase, int bodyCount, int frames, float staticShare = 0.f)
+{
+	ecs::Scene scene;
+	scene.RegisterComponents<Transform, RigidBody, AABBCollider>();
+	scene.RegisterSystem<PhysicsSystem>(PhysicsSettings{ .Broadphase = broadphase, .CellSize = 100.f, .AllowSleeping = false })
+		.WithRead<Transform>()
+		.WithRead<RigidBody>()
+		.WithRead<AABBCollider>();
+	scene.BuildSystemGraph();
+
+	// About one neighbour per body: 50x50 boxes spread so each covers ~1/16 of a 200x200 tile
+	const float worldSize = 200.f * std::sqrt(static_cast<float>(bodyCount));
+
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> position(0.f, worldSize);
+	std::uniform_real_distribution<float> velocity(-100.f, 100.f);
+	const int staticCount = static_cast<int>(bodyCount * staticShare);
+
+	for (int i = 0; i < bodyCount; ++i)
+	{
+		ecs::Entity entity = scene.CreateEntity();
+		scene.AddComponent<Transform>(entity, { position(rng), position(rng) });
+		if (i < staticCount)
+		{
+			scene.AddComponent<RigidBody>(entity, RigidBody{ .Mass = 0.f });
+		}
+		else
+		{
+			scene.AddComponent<RigidBody>(entity, RigidBody{ .Velocity = { velocity(rng), velocity(rng) } });
+		}
+		scene.AddComponent<AABBCollider>(entity);
+	}
+
+	const float dt = 1.f / 60.f;
+
+	// Warm-up step lets the system entities and scratch buffers settle
+	scene.Frame(dt);
+	scene.ConfirmChanges();
+
+	const auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		scene.Frame(dt);
+		scene.ConfirmChanges();
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	return elapsed.count() / frames;
+}
+
+inline void Run()
+{
+	std::cout << "--- Broadphase Benchmark ---" << std::endl;
+
+	for (int bodyCount : { 1'000, 10'000, 100'000 })
+	{
+		const double hash = MeasureStep(BroadphaseKind::SpatialHash, bodyCount, 60);
+		const double sweep = MeasureStep(BroadphaseKind::SweepAndPrune, bodyCount, 60);
+		const double tree = MeasureStep(BroadphaseKind::AABBTree, bodyCount, 60);
+		// The nested loop takes seconds per step at 100k bodies
+		const double bruteForce = MeasureStep(BroadphaseKind::BruteForce, bodyCount, bodyCount >= 100'000 ? 1 : 10);
+
+		std::cout << "Bodies: " << bodyCount << std::endl;
+		std::cout << "   Nested loop: " << bruteForce * 1000.0 << " ms/step" << std::endl;
+		std::cout << "   Spatial hash: " << hash * 1000.0 << " ms/step" << std::endl;
+		std::cout << "   Sweep and prune: " << sweep * 1000.0 << " ms/step" << std::endl;
+		std::cout << "   AABB tree: " << tree * 1000.0 << " ms/step" << std::endl;
+		std::cout << "   Speedup: " << bruteForce / std::min({ hash, sweep, tree }) << "x" << std::endl;
+	}
+
+	// A level: most colliders are static geometry, a few bodies move through it
+	std::cout << "Level, 100000 bodies, 95% static" << std::endl;
+	for (auto [name, broadphase] : { std::pair{ "Spatial hash", BroadphaseKind::SpatialHash },
+			 std::pair{ "Sweep and prune", BroadphaseKind::SweepAndPrune },
+			 std::pair{ "AABB tree", BroadphaseKind::AABBTree } })
+	{
+		std::cout << "   " << name << ": " << MeasureStep(broadphase, 100'000, 60, 0.95f) * 1000.0 << " ms/step" << std::endl;
+	}
+}
+
+} // namespace BroadphaseBenchmark
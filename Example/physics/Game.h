@@ -38,7 +38,8 @@ public:
 		auto& scene = Scene();
 
 		// --- 1. Register all components and systems with the ECS ---
-		scene.RegisterComponents<Transform, Input, RigidBody, Renderable, AABBCollider, ScriptComponent>();
+		scene.RegisterComponents<Transform, RigidBody, Renderable, AABBCollider, ScriptComponent>();
+		scene.SetResource<Input>();
 
 		scene.RegisterSystem<PhysicsSystem>()
 			.WithRead<Transform>()
@@ -46,7 +47,8 @@ public:
 			.WithRead<AABBCollider>();
 
 		scene.RegisterSystem<ScriptingSystem>()
-			.WithRead<ScriptComponent>();
+			.WithRead<ScriptComponent>()
+			.WithResourceRead<Input>();
 
 		scene.BuildSystemGraph();
 
@@ -76,7 +78,6 @@ public:
 		scene.AddComponent<RigidBody>(m_player, RigidBody{ .Mass = 1000.f });
 		scene.AddComponent<AABBCollider>(m_player);
 		scene.AddComponent<Renderable>(m_player, Renderable{ .color = { 1.f, 0.f, 0.f, 1.f } });
-		scene.AddComponent<Input>(m_player);
 		scene.AddComponent<ScriptComponent>(m_player);
 
 		scripts::Bind<PlayerController>(scene, m_player);
@@ -92,7 +93,7 @@ public:
 			Close();
 		}
 
-		auto& playerInput = scene.GetComponent<Input>(m_player);
+		auto& playerInput = scene.GetResource<Input>();
 		playerInput.moveLeft = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
 		playerInput.moveRight = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
 		playerInput.moveUp = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
@@ -24,7 +24,7 @@ public:
 	void OnUpdate(float) override
 	{
 		auto& body = GetComponent<Engine::physics::components::RigidBody>();
-		const auto& input = GetComponent<Input>();
+		const auto& input = Scene().GetResource<Input>();
 
 		body.Velocity.X = 0.f;
 		body.Velocity.Y = 0.f;
@@ -37,5 +37,11 @@ public:
 			body.Velocity.Y += 500.f;
 		if (input.moveDown)
 			body.Velocity.Y -= 500.f;
+
+		// Wakes the player if it fell asleep while standing still
+		if (body.Sleeping && body.Velocity != Engine::math::Vector2{})
+		{
+			Scene().MarkChanged<Engine::physics::components::RigidBody>(Entity());
+		}
 	}
 };
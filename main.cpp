@@ -6,6 +6,8 @@
 
 #define ENTT 0
 #define BENCHMARK_ON 0
+#define BROADPHASE_BENCHMARK 0
+#define AABB_OVERLAP_BENCHMARK 0
 
 #if ENTT
 #include "Example/entt/Scene.h"
@@ -18,6 +20,14 @@ using namespace Engine::ecs;
 #include "Example/physics/Game.h"
 #endif
 
+#if BROADPHASE_BENCHMARK
+#include "Example/benchmark/BroadphaseBenchmark.h"
+#endif
+
+#if AABB_OVERLAP_BENCHMARK
+#include "Example/benchmark/AABBOverlapBenchmark.h"
+#endif
+
 #if BENCHMARK_ON
 
 #include "Timer.h"
@@ -187,7 +197,13 @@ public:
 
 int main()
 {
-#if BENCHMARK_ON
+#if BROADPHASE_BENCHMARK
+	BroadphaseBenchmark::Run();
+	return 0;
+#elif AABB_OVERLAP_BENCHMARK
+	AABBOverlapBenchmark::Run();
+	return 0;
+#elif BENCHMARK_ON
 	const int ENTITY_COUNT = 100'00;
 	const int BENCHMARK_SECONDS = 10;
 	const float FIXED_DT = 1.0f / 60.0f;